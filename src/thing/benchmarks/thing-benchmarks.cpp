@@ -0,0 +1,450 @@
+#include <thing.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Benchmarks of the entity manager operations at several world sizes.
+//
+// Usage: thing-benchmarks [--json] [--filter <text>] [--min-time <seconds>]
+//
+// Each benchmark runs until it has taken at least the minimum time, and
+// reports the mean wall-clock time per iteration. With --json, the results
+// are written in the layout of Google Benchmark's JSON output, with the
+// process CPU time per iteration as cpu_time, so that the usual tools can
+// compare two runs.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Position {
+    float x, y, z;
+};
+
+struct Velocity {
+    float x, y, z;
+};
+
+// Position and velocity in columns, one array per field.
+struct Body {
+    using Storage = ge::thing::storage::Columns;
+    float x, y, z, vx, vy, vz;
+    static constexpr auto fields = std::tuple{
+        &Body::x, &Body::y, &Body::z, &Body::vx, &Body::vy, &Body::vz};
+};
+
+template <int N>
+struct Extra {
+    int value;
+};
+
+// Keeps results of the measured code alive.
+volatile float sink;
+
+class State {
+public:
+    State(size_t entities, Clock::duration minTime)
+        : _entities(entities)
+        , _minTime(minTime)
+    { }
+
+    size_t entities() const
+    {
+        return _entities;
+    }
+
+    /**
+     * Loop condition of the measured code. The time between the first call
+     * and the last one counts, minus paused time. CPU time is only read at
+     * the ends and around pauses, since reading it is a system call.
+     */
+    bool keepRunning()
+    {
+        auto now = Clock::now();
+        if (_iterations == 0 && _elapsed == Clock::duration{}) {
+            _start = now;
+            _cpuStart = std::clock();
+            ++_iterations;
+            return true;
+        }
+        _elapsed += now - _start;
+        _start = now;
+        if (_elapsed < _minTime) {
+            ++_iterations;
+            return true;
+        }
+        _cpuElapsed += std::clock() - _cpuStart;
+        return false;
+    }
+
+    // Exclude setup work in the loop from the measurement.
+    void pause()
+    {
+        _elapsed += Clock::now() - _start;
+        _cpuElapsed += std::clock() - _cpuStart;
+    }
+
+    void resume()
+    {
+        _cpuStart = std::clock();
+        _start = Clock::now();
+    }
+
+    // Items processed per iteration, for the throughput.
+    void setItems(size_t items)
+    {
+        _items = items;
+    }
+
+    size_t iterations() const
+    {
+        return _iterations;
+    }
+
+    size_t items() const
+    {
+        return _items;
+    }
+
+    double nanoseconds() const
+    {
+        return std::chrono::duration<double, std::nano>(_elapsed).count() /
+            static_cast<double>(_iterations);
+    }
+
+    double cpuNanoseconds() const
+    {
+        return static_cast<double>(_cpuElapsed) * 1e9 / CLOCKS_PER_SEC /
+            static_cast<double>(_iterations);
+    }
+
+private:
+    size_t _entities;
+    Clock::duration _minTime;
+    Clock::time_point _start;
+    Clock::duration _elapsed {};
+    std::clock_t _cpuStart = 0;
+    std::clock_t _cpuElapsed = 0;
+    size_t _iterations = 0;
+    size_t _items = 0;
+};
+
+struct Benchmark {
+    const char* name;
+    std::function<void(State&)> function;
+};
+
+template <ge::thing::EntityBackend Manager>
+std::vector<ge::thing::Entity> populate(Manager& manager, size_t count)
+{
+    auto entities = manager.createEntities(count);
+    for (auto entity : entities) {
+        manager.add(entity, Position{1, 2, 3});
+        manager.add(entity, Velocity{1, 1, 1});
+    }
+    return entities;
+}
+
+void createKill(State& state)
+{
+    ge::thing::EntityManager manager;
+    std::vector<ge::thing::Entity> entities;
+    entities.reserve(state.entities());
+    while (state.keepRunning()) {
+        entities.clear();
+        for (size_t i = 0; i < state.entities(); i++) {
+            entities.push_back(manager.createEntity());
+        }
+        for (auto entity : entities) {
+            manager.killEntity(entity);
+        }
+    }
+    state.setItems(state.entities());
+}
+
+// Benchmarks templated over the backend also run with archetype storage.
+template <ge::thing::EntityBackend Manager>
+void addRemove(State& state)
+{
+    Manager manager;
+    auto entities = manager.createEntities(state.entities());
+    while (state.keepRunning()) {
+        for (auto entity : entities) {
+            manager.add(entity, Position{1, 2, 3});
+        }
+        for (auto entity : entities) {
+            manager.template remove<Position>(entity);
+        }
+    }
+    state.setItems(state.entities());
+}
+
+void randomAccess(State& state)
+{
+    ge::thing::EntityManager manager;
+    auto entities = populate(manager, state.entities());
+    std::shuffle(entities.begin(), entities.end(), std::mt19937{42});
+    const auto& constManager = manager;
+    while (state.keepRunning()) {
+        float sum = 0;
+        for (auto entity : entities) {
+            sum += constManager.component<Position>(entity).x;
+        }
+        sink = sum;
+    }
+    state.setItems(state.entities());
+}
+
+void gather(State& state, ge::thing::GatherOrder order)
+{
+    ge::thing::EntityManager manager;
+    auto entities = populate(manager, state.entities());
+    std::shuffle(entities.begin(), entities.end(), std::mt19937{42});
+    std::vector<Position> positions(entities.size());
+    while (state.keepRunning()) {
+        manager.gather<Position>(entities, positions, order);
+        sink = positions[0].x;
+    }
+    state.setItems(state.entities());
+}
+
+void gatherInput(State& state)
+{
+    gather(state, ge::thing::GatherOrder::Input);
+}
+
+void gatherDense(State& state)
+{
+    gather(state, ge::thing::GatherOrder::Dense);
+}
+
+void iterateSpan(State& state)
+{
+    ge::thing::EntityManager manager;
+    populate(manager, state.entities());
+    const auto& constManager = manager;
+    while (state.keepRunning()) {
+        float sum = 0;
+        for (const auto& position : constManager.components<Position>()) {
+            sum += position.x;
+        }
+        sink = sum;
+    }
+    state.setItems(state.entities());
+}
+
+template <ge::thing::EntityBackend Manager>
+void iterateView(State& state)
+{
+    Manager manager;
+    auto entities = populate(manager, state.entities());
+    while (state.keepRunning()) {
+        for (auto [entity, position, velocity] :
+                manager.template view<Position, const Velocity>()) {
+            position.x += velocity.x;
+            position.y += velocity.y;
+            position.z += velocity.z;
+        }
+    }
+    sink = manager.template component<Position>(entities[0]).x;
+    state.setItems(state.entities());
+}
+
+void iterateColumns(State& state)
+{
+    ge::thing::EntityManager manager;
+    for (auto entity : manager.createEntities(state.entities())) {
+        manager.add<Body>(entity, Body{1, 2, 3, 1, 1, 1});
+    }
+    while (state.keepRunning()) {
+        auto x = manager.column<&Body::x>();
+        auto y = manager.column<&Body::y>();
+        auto z = manager.column<&Body::z>();
+        auto vx = manager.column<&Body::vx>();
+        auto vy = manager.column<&Body::vy>();
+        auto vz = manager.column<&Body::vz>();
+        for (size_t i = 0; i < x.size(); i++) {
+            x[i] += vx[i];
+            y[i] += vy[i];
+            z[i] += vz[i];
+        }
+    }
+    sink = manager.column<&Body::x>()[0];
+    state.setItems(state.entities());
+}
+
+void cachedQuery(State& state)
+{
+    ge::thing::EntityManager manager;
+    auto entities = populate(manager, state.entities());
+    for (size_t i = 0; i < entities.size(); i += 2) {
+        manager.add<Extra<0>>(entities[i], Extra<0>{0});
+    }
+    ge::thing::Query<const Position, ge::thing::Without<Extra<0>>> query{
+        manager};
+    while (state.keepRunning()) {
+        float sum = 0;
+        for (auto [entity, position] : query) {
+            sum += position.x;
+        }
+        sink = sum;
+    }
+    state.setItems(query.size());
+}
+
+void cloneWorld(State& state)
+{
+    ge::thing::EntityManager manager;
+    populate(manager, state.entities());
+    while (state.keepRunning()) {
+        auto copy = manager.clone();
+        sink = copy.components<Position>()[0].x;
+    }
+    state.setItems(state.entities());
+}
+
+void killManyTypes(State& state)
+{
+    ge::thing::EntityManager manager;
+    std::vector<ge::thing::Entity> entities;
+    while (state.keepRunning()) {
+        state.pause();
+        entities = populate(manager, state.entities());
+        [&manager, &entities] <int... N> (
+                std::integer_sequence<int, N...>) {
+            (manager.addBatch<Extra<N>>(entities, Extra<N>{N}), ...);
+        }(std::make_integer_sequence<int, 8>{});
+        state.resume();
+
+        for (auto entity : entities) {
+            manager.killEntity(entity);
+        }
+    }
+    state.setItems(state.entities());
+}
+
+const Benchmark benchmarks[] = {
+    {"create_kill", createKill},
+    {"add_remove", addRemove<ge::thing::EntityManager>},
+    {"archetype_add_remove", addRemove<ge::thing::ArchetypeEntityManager>},
+    {"random_access", randomAccess},
+    {"gather", gatherInput},
+    {"gather_dense", gatherDense},
+    {"iterate_span", iterateSpan},
+    {"iterate_view", iterateView<ge::thing::EntityManager>},
+    {"archetype_iterate_view",
+        iterateView<ge::thing::ArchetypeEntityManager>},
+    {"iterate_columns", iterateColumns},
+    {"cached_query", cachedQuery},
+    {"clone", cloneWorld},
+    {"kill_many_types", killManyTypes},
+};
+
+const size_t sizes[] = {10'000, 100'000, 1'000'000};
+
+struct Result {
+    std::string name;
+    size_t iterations;
+    double nanoseconds;
+    double cpuNanoseconds;
+    double itemsPerSecond;
+};
+
+void printJson(const std::vector<Result>& results)
+{
+    std::printf("{\n  \"context\": {\n");
+    std::printf("    \"library\": \"thing\",\n");
+#ifdef NDEBUG
+    std::printf("    \"library_build_type\": \"release\"\n");
+#else
+    std::printf("    \"library_build_type\": \"debug\"\n");
+#endif
+    std::printf("  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        std::printf(
+            "    {\n"
+            "      \"name\": \"%s\",\n"
+            "      \"run_type\": \"iteration\",\n"
+            "      \"iterations\": %zu,\n"
+            "      \"real_time\": %.1f,\n"
+            "      \"cpu_time\": %.1f,\n"
+            "      \"time_unit\": \"ns\",\n"
+            "      \"items_per_second\": %.1f\n"
+            "    }%s\n",
+            result.name.c_str(), result.iterations, result.nanoseconds,
+            result.cpuNanoseconds, result.itemsPerSecond,
+            i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bool json = false;
+    std::string_view filter;
+    std::chrono::duration<double> minTime{0.5};
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            minTime = std::chrono::duration<double>{std::atof(argv[++i])};
+        } else {
+            std::fprintf(
+                stderr,
+                "usage: %s [--json] [--filter <text>] "
+                "[--min-time <seconds>]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    for (const auto& benchmark : benchmarks) {
+        for (auto size : sizes) {
+            auto name = std::string{benchmark.name} + "/" +
+                std::to_string(size);
+            if (name.find(filter) == std::string::npos) {
+                continue;
+            }
+
+            State state{
+                size,
+                std::chrono::duration_cast<Clock::duration>(minTime)};
+            benchmark.function(state);
+            auto nanoseconds = state.nanoseconds();
+            results.push_back({
+                name,
+                state.iterations(),
+                nanoseconds,
+                state.cpuNanoseconds(),
+                static_cast<double>(state.items()) * 1e9 / nanoseconds});
+            if (!json) {
+                std::printf(
+                    "%-32s %12.0f ns %10zu iterations %14.0f items/s\n",
+                    name.c_str(), nanoseconds, state.iterations(),
+                    results.back().itemsPerSecond);
+            }
+        }
+    }
+    if (json) {
+        printJson(results);
+    }
+    return 0;
+}
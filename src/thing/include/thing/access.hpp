@@ -0,0 +1,414 @@
+#pragma once
+
+#include <thing/component_id.hpp>
+#include <thing/components.hpp>
+#include <thing/entity.hpp>
+#include <thing/tick.hpp>
+#include <thing/view.hpp>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ge::thing {
+
+class EntityManager;
+
+namespace internals {
+
+/**
+ * The lock between access tokens, which hold it shared, and structural
+ * changes, which hold it exclusively. Waiting writers keep new holders from
+ * getting in, so that they are not starved by a steady stream of tokens on
+ * other threads.
+ *
+ * A thread holds one token at a time, across all managers: tokens taken one
+ * after another could lock pools in different orders on two threads, and
+ * even two read tokens can then wait on each other through writers queued
+ * on their pools. For the same reason, a thread that holds a token cannot
+ * wait for the structure lock of any manager. The hold is recorded per
+ * thread, so a token must be released on the thread that acquired it.
+ */
+class StructureMutex {
+public:
+    StructureMutex() = default;
+    StructureMutex(const StructureMutex&) = delete;
+    StructureMutex& operator=(const StructureMutex&) = delete;
+
+    /**
+     * Whether the thread holds an access token, of any manager.
+     */
+    static bool heldByThread()
+    {
+        return threadHold() != nullptr;
+    }
+
+    /**
+     * Throws std::logic_error if the thread holds an access token, of this
+     * manager, which would wait for itself, or of another one, whose
+     * structure lock may be waited for by a token holder of this one.
+     */
+    void lock()
+    {
+        if (heldByThread()) {
+            throw std::logic_error{
+                "ge::thing::EntityManager::lockStructure: "
+                "the thread holds an access token"};
+        }
+        std::unique_lock lock{_mutex};
+        ++_waitingWriters;
+        _writable.wait(lock, [this] {
+            return !_writer && _readers == 0;
+        });
+        --_waitingWriters;
+        _writer = true;
+    }
+
+    void unlock()
+    {
+        {
+            std::lock_guard lock{_mutex};
+            _writer = false;
+        }
+        _writable.notify_one();
+        _readable.notify_all();
+    }
+
+    /**
+     * Throws std::logic_error if the thread holds an access token, of this
+     * manager or another one.
+     */
+    void lock_shared()
+    {
+        auto& hold = threadHold();
+        if (hold) {
+            throw std::logic_error{
+                "ge::thing::EntityManager: the thread holds an access token"};
+        }
+        {
+            std::unique_lock lock{_mutex};
+            _readable.wait(lock, [this] {
+                return !_writer && _waitingWriters == 0;
+            });
+            ++_readers;
+        }
+        hold = this;
+    }
+
+    void unlock_shared()
+    {
+        threadHold() = nullptr;
+        bool last = false;
+        {
+            std::lock_guard lock{_mutex};
+            last = --_readers == 0;
+        }
+        if (last) {
+            _writable.notify_one();
+        }
+    }
+
+private:
+    // The mutex the thread holds shared, if any. It is reset on release, so
+    // the address of a destroyed mutex cannot be left behind.
+    static const StructureMutex*& threadHold()
+    {
+        thread_local const StructureMutex* hold = nullptr;
+        return hold;
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _readable;
+    std::condition_variable _writable;
+    size_t _readers = 0;
+    size_t _waitingWriters = 0;
+    bool _writer = false;
+};
+
+/**
+ * Locks of the pools of one token, taken in the order of their component
+ * IDs so that tokens for overlapping sets on different threads cannot
+ * deadlock each other, and released in reverse order. Missing pools are
+ * skipped.
+ */
+template <bool Exclusive, size_t Count>
+class PoolLocks {
+public:
+    using Pool = std::pair<ComponentId, const AbstractComponents*>;
+
+    explicit PoolLocks(std::array<Pool, Count> pools)
+    {
+        std::sort(pools.begin(), pools.end(), [] (auto lhs, auto rhs) {
+            return lhs.first < rhs.first;
+        });
+        for (auto [id, pool] : pools) {
+            if (!pool ||
+                    (_count > 0 && _mutexes[_count - 1] == &pool->mutex())) {
+                continue;
+            }
+            auto& mutex = pool->mutex();
+            if constexpr (Exclusive) {
+                mutex.lock();
+            } else {
+                mutex.lock_shared();
+            }
+            _mutexes[_count++] = &mutex;
+        }
+    }
+
+    PoolLocks(const PoolLocks&) = delete;
+    PoolLocks& operator=(const PoolLocks&) = delete;
+
+    ~PoolLocks()
+    {
+        while (_count > 0) {
+            auto& mutex = *_mutexes[--_count];
+            if constexpr (Exclusive) {
+                mutex.unlock();
+            } else {
+                mutex.unlock_shared();
+            }
+        }
+    }
+
+private:
+    std::array<std::shared_mutex*, Count> _mutexes {};
+    size_t _count = 0;
+};
+
+} // namespace internals
+
+/**
+ * Shared access to the pools of the components, for reading them on
+ * another thread than the one that changes the manager. See
+ * EntityManager::readAccess().
+ *
+ * The pools are looked up and locked once, when the token is acquired;
+ * everything done through the token afterwards takes no locks. Only the
+ * listed components can be accessed.
+ */
+template <class... Components>
+class ReadAccess {
+    static_assert(sizeof...(Components) > 0);
+
+public:
+    ReadAccess(const ReadAccess&) = delete;
+    ReadAccess& operator=(const ReadAccess&) = delete;
+
+    template <class Component>
+    bool has(Entity entity) const
+    {
+        auto pool = this->pool<Component>();
+        return pool && pool->contains(entity);
+    }
+
+    /**
+     * Throws std::out_of_range if the entity does not have the component.
+     */
+    template <class Component>
+    internals::ReferenceFor<const Component> component(Entity entity) const
+    {
+        auto pool = this->pool<Component>();
+        if (!pool) {
+            throw std::out_of_range{"ge::thing::ReadAccess::component"};
+        }
+        return pool->component(entity);
+    }
+
+    template <class Component>
+    std::span<const Component> components() const
+    {
+        auto pool = this->pool<Component>();
+        return pool ? pool->components() : std::span<const Component>{};
+    }
+
+    template <class Component>
+    std::span<const Entity> entities() const
+    {
+        auto pool = this->pool<Component>();
+        return pool ? pool->entities() : std::span<const Entity>{};
+    }
+
+    /**
+     * See EntityManager::view(); the components are always const.
+     */
+    template <class... Terms>
+    View<internals::ConstTermOf<Terms>...> view(Tick since = 0) const
+    {
+        return View<internals::ConstTermOf<Terms>...>{
+            since,
+            pool<std::remove_const_t<internals::TermComponent<Terms>>>()...};
+    }
+
+private:
+    friend class EntityManager;
+
+    ReadAccess(
+            std::shared_lock<internals::StructureMutex> structure,
+            const internals::OneTypeComponents<Components>*... pools)
+        : _structure(std::move(structure))
+        , _pools(pools...)
+        , _locks({typename Locks::Pool{componentId<Components>(), pools}...})
+    { }
+
+    template <class Component>
+    const internals::OneTypeComponents<Component>* pool() const
+    {
+        static_assert(
+            (... || std::is_same_v<Component, Components>),
+            "the component is not covered by the access");
+        return std::get<const internals::OneTypeComponents<Component>*>(
+            _pools);
+    }
+
+    using Locks = internals::PoolLocks<false, sizeof...(Components)>;
+
+    std::shared_lock<internals::StructureMutex> _structure;
+    std::tuple<const internals::OneTypeComponents<Components>*...> _pools;
+    Locks _locks;
+};
+
+/**
+ * Exclusive access to the pools of the components. See
+ * EntityManager::writeAccess().
+ *
+ * Besides reading and writing components, components can be added to live
+ * entities, unless their pool is owned by a group, which would touch other
+ * pools, or has hooks, which would run on the thread of the token while
+ * tokens on other threads call them too; a Query or a Collector registers
+ * hooks. Removing components and killing entities are structural changes.
+ */
+template <class... Components>
+class WriteAccess {
+    static_assert(sizeof...(Components) > 0);
+
+public:
+    WriteAccess(const WriteAccess&) = delete;
+    WriteAccess& operator=(const WriteAccess&) = delete;
+
+    template <class Component>
+    bool has(Entity entity) const
+    {
+        return pool<Component>().contains(entity);
+    }
+
+    template <class Component>
+    internals::ReferenceFor<const Component> component(Entity entity) const
+    {
+        return std::as_const(pool<Component>()).component(entity);
+    }
+
+    /**
+     * Mutable access marks the component as changed at the current tick.
+     */
+    template <class Component>
+    internals::ReferenceFor<Component> component(Entity entity)
+    {
+        return pool<Component>().component(entity);
+    }
+
+    template <class Component>
+    void markChanged(Entity entity)
+    {
+        pool<Component>().markChanged(entity);
+    }
+
+    /**
+     * Writes through the span are not tracked as changes.
+     */
+    template <class Component>
+    std::span<Component> components()
+    {
+        return pool<Component>().components();
+    }
+
+    template <class Component>
+    std::span<const Entity> entities() const
+    {
+        return pool<Component>().entities();
+    }
+
+    template <class... Terms>
+    View<Terms...> view(Tick since = 0)
+    {
+        return View<Terms...>{
+            since,
+            &pool<std::remove_const_t<internals::TermComponent<Terms>>>()...};
+    }
+
+    /**
+     * Throws std::invalid_argument if the entity is not alive, and
+     * std::logic_error if the pool is owned by a group or has hooks.
+     */
+    template <class Component>
+    internals::ReferenceFor<Component> add(Entity entity)
+    {
+        return writablePool<Component>(entity).add(entity);
+    }
+
+    template <class Component>
+    internals::ReferenceFor<Component> add(
+        Entity entity, Component&& component)
+    {
+        return writablePool<Component>(entity).add(
+            entity, std::move(component));
+    }
+
+private:
+    friend class EntityManager;
+
+    WriteAccess(
+            std::shared_lock<internals::StructureMutex> structure,
+            const internals::EntityPool& entityPool,
+            internals::OneTypeComponents<Components>&... pools)
+        : _structure(std::move(structure))
+        , _entityPool(entityPool)
+        , _pools(&pools...)
+        , _locks({typename Locks::Pool{componentId<Components>(), &pools}...})
+    { }
+
+    template <class Component>
+    internals::OneTypeComponents<Component>& pool() const
+    {
+        static_assert(
+            (... || std::is_same_v<Component, Components>),
+            "the component is not covered by the access");
+        return *std::get<internals::OneTypeComponents<Component>*>(_pools);
+    }
+
+    template <class Component>
+    internals::OneTypeComponents<Component>& writablePool(Entity entity)
+    {
+        if (!_entityPool.alive(entity)) {
+            throw std::invalid_argument{
+                "ge::thing::WriteAccess: entity is not alive"};
+        }
+        auto& pool = this->pool<Component>();
+        if (pool.group()) {
+            throw std::logic_error{
+                "ge::thing::WriteAccess::add: pool is owned by a group"};
+        }
+        if (pool.hooked()) {
+            throw std::logic_error{
+                "ge::thing::WriteAccess::add: pool has hooks"};
+        }
+        return pool;
+    }
+
+    using Locks = internals::PoolLocks<true, sizeof...(Components)>;
+
+    std::shared_lock<internals::StructureMutex> _structure;
+    const internals::EntityPool& _entityPool;
+    std::tuple<internals::OneTypeComponents<Components>*...> _pools;
+    Locks _locks;
+};
+
+} // namespace ge::thing
@@ -0,0 +1,711 @@
+#pragma once
+
+#include <thing/component_id.hpp>
+#include <thing/entity.hpp>
+#include <thing/term.hpp>
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+namespace internals {
+
+// Make room for one more element, growing the capacity geometrically.
+template <class Vector>
+void reserveRow(Vector& vector)
+{
+    if (vector.size() == vector.capacity()) {
+        vector.reserve(std::max<size_t>(2 * vector.capacity(), 8));
+    }
+}
+
+class AbstractColumn {
+public:
+    virtual ~AbstractColumn() {}
+    virtual std::unique_ptr<AbstractColumn> createEmpty() const = 0;
+    virtual void reserveRow() = 0;
+    virtual void moveRow(size_t row, AbstractColumn& target) = 0;
+    virtual void removeRow(size_t row) = 0;
+};
+
+template <class Component>
+class Column final : public AbstractColumn {
+public:
+    std::span<const Component> values() const
+    {
+        return _values;
+    }
+
+    std::span<Component> values()
+    {
+        return _values;
+    }
+
+    Component& push(Component&& component)
+    {
+        _values.push_back(std::move(component));
+        return _values.back();
+    }
+
+    std::unique_ptr<AbstractColumn> createEmpty() const override
+    {
+        return std::make_unique<Column>();
+    }
+
+    void reserveRow() override
+    {
+        internals::reserveRow(_values);
+    }
+
+    void moveRow(size_t row, AbstractColumn& target) override
+    {
+        static_cast<Column&>(target).push(std::move(_values[row]));
+    }
+
+    void removeRow(size_t row) override
+    {
+        if (row != _values.size() - 1) {
+            _values[row] = std::move(_values.back());
+        }
+        _values.pop_back();
+    }
+
+private:
+    std::vector<Component> _values;
+};
+
+template <class Component>
+using ColumnFor = std::conditional_t<
+    std::is_const_v<Component>,
+    const Column<std::remove_const_t<Component>>,
+    Column<Component>>;
+
+/**
+ * A table of all entities that have exactly the same set of components. Each
+ * component type is stored in its own contiguous column, and row N of every
+ * column belongs to the N-th entity.
+ */
+class Archetype {
+public:
+    using Signature = std::vector<ComponentId>;
+
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    Archetype() = default;
+
+    explicit Archetype(
+        std::vector<std::pair<ComponentId, std::unique_ptr<AbstractColumn>>>
+            columns)
+    {
+        std::sort(
+            columns.begin(),
+            columns.end(),
+            [] (const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            });
+        for (auto& [type, column] : columns) {
+            _signature.push_back(type);
+            _columns.push_back(std::move(column));
+        }
+    }
+
+    const Signature& signature() const
+    {
+        return _signature;
+    }
+
+    size_t size() const
+    {
+        return _entities.size();
+    }
+
+    std::span<const Entity> entities() const
+    {
+        return _entities;
+    }
+
+    size_t find(ComponentId type) const
+    {
+        auto it = std::lower_bound(_signature.begin(), _signature.end(), type);
+        if (it == _signature.end() || *it != type) {
+            return npos;
+        }
+        return static_cast<size_t>(it - _signature.begin());
+    }
+
+    bool contains(ComponentId type) const
+    {
+        return find(type) != npos;
+    }
+
+    const AbstractColumn& column(size_t index) const
+    {
+        return *_columns[index];
+    }
+
+    AbstractColumn& column(size_t index)
+    {
+        return *_columns[index];
+    }
+
+    template <class Component>
+    const Column<Component>& column() const
+    {
+        return static_cast<const Column<Component>&>(
+            *_columns.at(find(componentId<Component>())));
+    }
+
+    template <class Component>
+    Column<Component>& column()
+    {
+        return static_cast<Column<Component>&>(
+            *_columns.at(find(componentId<Component>())));
+    }
+
+    /**
+     * Create empty columns for a new archetype: all columns of this one,
+     * except for the type being removed, if any.
+     */
+    std::vector<std::pair<ComponentId, std::unique_ptr<AbstractColumn>>>
+    createColumns(size_t except = npos) const
+    {
+        std::vector<
+            std::pair<ComponentId, std::unique_ptr<AbstractColumn>>>
+                columns;
+        for (size_t i = 0; i < _columns.size(); i++) {
+            if (i != except) {
+                columns.emplace_back(_signature[i], _columns[i]->createEmpty());
+            }
+        }
+        return columns;
+    }
+
+    /**
+     * Make room for one more row in every column and in the entities, so
+     * that pushing a row cannot fail for lack of memory.
+     */
+    void reserveRow()
+    {
+        internals::reserveRow(_entities);
+        for (auto& column : _columns) {
+            column->reserveRow();
+        }
+    }
+
+    /**
+     * Push the entity of a row whose values are already in the columns.
+     */
+    size_t pushEntity(Entity entity)
+    {
+        _entities.push_back(entity);
+        return _entities.size() - 1;
+    }
+
+    /**
+     * Move the row into another archetype. Columns missing from the target
+     * are dropped. The entity is pushed to the target afterwards.
+     */
+    void moveRow(size_t row, Archetype& target)
+    {
+        for (size_t i = 0; i < _columns.size(); i++) {
+            if (auto index = target.find(_signature[i]); index != npos) {
+                _columns[i]->moveRow(row, *target._columns[index]);
+            }
+        }
+    }
+
+    /**
+     * Swap-remove the row. Returns the entity that has taken its place, if
+     * any.
+     */
+    std::optional<Entity> removeRow(size_t row)
+    {
+        for (auto& column : _columns) {
+            column->removeRow(row);
+        }
+
+        std::optional<Entity> moved;
+        if (row != _entities.size() - 1) {
+            _entities[row] = _entities.back();
+            moved = _entities[row];
+        }
+        _entities.pop_back();
+        return moved;
+    }
+
+    Archetype* addEdge(ComponentId type) const
+    {
+        auto it = _addEdges.find(type);
+        return it == _addEdges.end() ? nullptr : it->second;
+    }
+
+    Archetype* removeEdge(ComponentId type) const
+    {
+        auto it = _removeEdges.find(type);
+        return it == _removeEdges.end() ? nullptr : it->second;
+    }
+
+    void setEdges(ComponentId type, Archetype& withType)
+    {
+        _addEdges[type] = &withType;
+        withType._removeEdges[type] = this;
+    }
+
+private:
+    Signature _signature;
+    std::vector<std::unique_ptr<AbstractColumn>> _columns;
+    std::vector<Entity> _entities;
+    std::map<ComponentId, Archetype*> _addEdges;
+    std::map<ComponentId, Archetype*> _removeEdges;
+};
+
+} // namespace internals
+
+/**
+ * Iterates over all archetypes that contain the given components. Within each
+ * archetype, the columns are walked linearly.
+ */
+template <class... Components>
+class ArchetypeView {
+    static_assert(sizeof...(Components) > 0);
+
+    using ArchetypePointer = std::conditional_t<
+        (... && std::is_const_v<Components>),
+        const internals::Archetype*,
+        internals::Archetype*>;
+
+    struct Table {
+        ArchetypePointer archetype;
+        std::array<size_t, sizeof...(Components)> columns;
+    };
+
+public:
+    using value_type = std::tuple<Entity, Components&...>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = ArchetypeView::value_type;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        Iterator(const ArchetypeView* view, size_t table, size_t row)
+            : _view(view)
+            , _table(table)
+            , _row(row)
+        {
+            skip();
+        }
+
+        value_type operator*() const
+        {
+            return _view->get(
+                _view->_tables[_table],
+                _row,
+                std::index_sequence_for<Components...>{});
+        }
+
+        Iterator& operator++()
+        {
+            ++_row;
+            skip();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs)
+        {
+            return lhs._table == rhs._table && lhs._row == rhs._row;
+        }
+
+    private:
+        void skip()
+        {
+            while (_table < _view->_tables.size() &&
+                    _row >= _view->_tables[_table].archetype->size()) {
+                ++_table;
+                _row = 0;
+            }
+        }
+
+        const ArchetypeView* _view = nullptr;
+        size_t _table = 0;
+        size_t _row = 0;
+    };
+
+    ArchetypeView() = default;
+
+    template <class Archetypes>
+    explicit ArchetypeView(Archetypes& archetypes)
+    {
+        for (auto& archetype : archetypes) {
+            auto table = Table{
+                archetype.get(),
+                {archetype->find(
+                    componentId<Components>())...}};
+            if (std::find(
+                    table.columns.begin(),
+                    table.columns.end(),
+                    internals::Archetype::npos) == table.columns.end()) {
+                _tables.push_back(table);
+            }
+        }
+    }
+
+    Iterator begin() const
+    {
+        return Iterator{this, 0, 0};
+    }
+
+    Iterator end() const
+    {
+        return Iterator{this, _tables.size(), 0};
+    }
+
+    size_t size() const
+    {
+        size_t size = 0;
+        for (const auto& table : _tables) {
+            size += table.archetype->size();
+        }
+        return size;
+    }
+
+    template <class Function>
+    void each(Function&& function) const
+    {
+        for (auto&& tuple : *this) {
+            std::apply(function, tuple);
+        }
+    }
+
+    /**
+     * Call function(std::span<const Entity>, std::span<Components>...) once
+     * for each matching archetype.
+     */
+    template <class Function>
+    void eachChunk(Function&& function) const
+    {
+        for (const auto& table : _tables) {
+            if (table.archetype->size() > 0) {
+                callChunk(
+                    function,
+                    table,
+                    std::index_sequence_for<Components...>{});
+            }
+        }
+    }
+
+private:
+    template <size_t I>
+    auto& column(const Table& table) const
+    {
+        using Component = std::tuple_element_t<I, std::tuple<Components...>>;
+        return static_cast<internals::ColumnFor<Component>&>(
+            table.archetype->column(table.columns[I]));
+    }
+
+    template <size_t... I>
+    value_type get(
+        const Table& table, size_t row, std::index_sequence<I...>) const
+    {
+        return value_type{
+            table.archetype->entities()[row],
+            column<I>(table).values()[row]...};
+    }
+
+    template <class Function, size_t... I>
+    void callChunk(
+        Function& function,
+        const Table& table,
+        std::index_sequence<I...>) const
+    {
+        function(table.archetype->entities(), column<I>(table).values()...);
+    }
+
+    std::vector<Table> _tables;
+};
+
+/**
+ * Experimental entity manager that stores components in archetype tables
+ * instead of one pool per component type, to compare the two layouts. It
+ * only offers the operations of the EntityBackend concept; per-type spans
+ * do not exist with this layout, and ticks, hooks, groups, snapshots,
+ * cloning and access tokens are left to EntityManager.
+ */
+class ArchetypeEntityManager {
+public:
+    ArchetypeEntityManager()
+    {
+        _archetypes.push_back(std::make_unique<internals::Archetype>());
+        _archetypeIndex[{}] = _archetypes.front().get();
+    }
+
+    template <class Component>
+    bool has(Entity entity) const
+    {
+        return alive(entity) &&
+            _locations[entity.index()].archetype->contains(
+                componentId<Component>());
+    }
+
+    /**
+     * Throws std::out_of_range if the entity is dead or does not have the
+     * component.
+     */
+    template <class Component>
+    const Component& component(Entity entity) const
+    {
+        if (!has<Component>(entity)) {
+            throw std::out_of_range{
+                "ge::thing::ArchetypeEntityManager::component"};
+        }
+        const auto& location = _locations[entity.index()];
+        return location.archetype->column<Component>().values()[
+            location.row];
+    }
+
+    template <class Component>
+    Component& component(Entity entity)
+    {
+        return const_cast<Component&>(
+            std::as_const(*this).component<Component>(entity));
+    }
+
+    /**
+     * Components are mutable unless const or wrapped into Read<>, as with
+     * EntityManager::view().
+     */
+    template <class... Terms>
+    ArchetypeView<const internals::AccessType<Terms>...> view() const
+    {
+        return ArchetypeView<const internals::AccessType<Terms>...>{
+            _archetypes};
+    }
+
+    template <class... Terms>
+    ArchetypeView<internals::AccessType<Terms>...> view()
+    {
+        return ArchetypeView<internals::AccessType<Terms>...>{_archetypes};
+    }
+
+    template <class Component>
+    Component& add(Entity entity)
+        requires std::default_initializable<Component>
+    {
+        if (has<Component>(entity)) {
+            return component<Component>(entity);
+        }
+        return add(entity, Component{});
+    }
+
+    template <class Component>
+    Component& add(Entity entity, Component&& component)
+    {
+        ComponentId type = componentId<Component>();
+        auto& location = locate(entity);
+        auto& source = *location.archetype;
+        if (auto index = source.find(type);
+                index != internals::Archetype::npos) {
+            auto& ref = static_cast<internals::Column<Component>&>(
+                source.column(index)).values()[location.row];
+            ref = std::move(component);
+            return ref;
+        }
+
+        internals::Archetype* target = source.addEdge(type);
+        if (!target) {
+            auto signature = source.signature();
+            signature.insert(
+                std::lower_bound(signature.begin(), signature.end(), type),
+                type);
+            target = &archetype(signature, [&source] {
+                auto columns = source.createColumns();
+                columns.emplace_back(
+                    componentId<Component>(),
+                    std::make_unique<internals::Column<Component>>());
+                return columns;
+            });
+            source.setEdges(type, *target);
+        }
+
+        Component* added = nullptr;
+        move(entity, *target, [&] {
+            added = &target->column<Component>().push(std::move(component));
+        });
+        return *added;
+    }
+
+    /**
+     * Add a copy of the component to each of the entities. Throws
+     * std::invalid_argument, before adding any, if one is dead.
+     */
+    template <class Component>
+    void addBatch(std::span<const Entity> entities, const Component& component)
+    {
+        for (auto entity : entities) {
+            locate(entity);
+        }
+        for (auto entity : entities) {
+            add(entity, Component{component});
+        }
+    }
+
+    template <class Component>
+    void remove(Entity entity)
+    {
+        if (!alive(entity)) {
+            return;
+        }
+        ComponentId type = componentId<Component>();
+        auto& source = *locate(entity).archetype;
+        auto index = source.find(type);
+        if (index == internals::Archetype::npos) {
+            return;
+        }
+
+        internals::Archetype* target = source.removeEdge(type);
+        if (!target) {
+            auto signature = source.signature();
+            signature.erase(signature.begin() + index);
+            target = &archetype(signature, [&source, index] {
+                return source.createColumns(index);
+            });
+            target->setEdges(type, source);
+        }
+
+        move(entity, *target, [] {});
+    }
+
+    Entity createEntity()
+    {
+        auto entity = _entityPool.createEntity();
+        if (_locations.size() <= entity.index()) {
+            _locations.resize(entity.index() + 1);
+        }
+        auto& root = *_archetypes.front();
+        _locations[entity.index()] = {&root, root.pushEntity(entity)};
+        return entity;
+    }
+
+    std::vector<Entity> createEntities(size_t count)
+    {
+        std::vector<Entity> entities;
+        entities.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            entities.push_back(createEntity());
+        }
+        return entities;
+    }
+
+    void killEntity(Entity entity)
+    {
+        if (!alive(entity)) {
+            return;
+        }
+
+        auto& location = locate(entity);
+        if (auto moved = location.archetype->removeRow(location.row)) {
+            _locations[moved->index()].row = location.row;
+        }
+        location = {};
+        _entityPool.killEntity(entity);
+    }
+
+    bool alive(Entity entity) const
+    {
+        return _entityPool.alive(entity);
+    }
+
+    size_t archetypeCount() const
+    {
+        return _archetypes.size();
+    }
+
+private:
+    struct Location {
+        internals::Archetype* archetype = nullptr;
+        size_t row = 0;
+    };
+
+    const Location& locate(Entity entity) const
+    {
+        if (!_entityPool.alive(entity)) {
+            throw std::invalid_argument{
+                "ge::thing::ArchetypeEntityManager: entity is not alive"};
+        }
+        return _locations[entity.index()];
+    }
+
+    Location& locate(Entity entity)
+    {
+        return const_cast<Location&>(
+            std::as_const(*this).locate(entity));
+    }
+
+    template <class CreateColumns>
+    internals::Archetype& archetype(
+        const internals::Archetype::Signature& signature,
+        CreateColumns&& createColumns)
+    {
+        auto& archetype = _archetypeIndex[signature];
+        if (!archetype) {
+            _archetypes.push_back(
+                std::make_unique<internals::Archetype>(createColumns()));
+            archetype = _archetypes.back().get();
+        }
+        return *archetype;
+    }
+
+    // Move the row of the entity to the target, where pushValues() adds
+    // the values of the columns that the source does not have. Room for the
+    // row is reserved first, and the entity is pushed last, so that the
+    // tables stay consistent if memory runs out. Component move
+    // constructors must not throw.
+    template <class PushValues>
+    void move(
+        Entity entity,
+        internals::Archetype& target,
+        PushValues&& pushValues)
+    {
+        auto& location = locate(entity);
+        target.reserveRow();
+        location.archetype->moveRow(location.row, target);
+        pushValues();
+        auto row = target.pushEntity(entity);
+        if (auto moved = location.archetype->removeRow(location.row)) {
+            _locations[moved->index()].row = location.row;
+        }
+        location = {&target, row};
+    }
+
+    internals::EntityPool _entityPool;
+    std::vector<std::unique_ptr<internals::Archetype>> _archetypes;
+    std::map<internals::Archetype::Signature, internals::Archetype*>
+        _archetypeIndex;
+    std::vector<Location> _locations;
+};
+
+} // namespace ge::thing
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <thing/entity.hpp>
+
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+namespace internals {
+
+// Stands in for any component type in the requirements below.
+struct BackendProbe {
+    int value;
+};
+
+} // namespace internals
+
+/**
+ * The entity and component operations that EntityManager and
+ * ArchetypeEntityManager share, so that code such as benchmarks can be
+ * written once for either storage backend. Both treat dead entities
+ * alike: has() returns false, remove() does nothing, component() throws
+ * std::out_of_range, and add() and addBatch() throw std::invalid_argument.
+ */
+template <class Manager>
+concept EntityBackend = requires(
+        Manager& manager,
+        const Manager& constManager,
+        Entity entity,
+        std::span<const Entity> entities,
+        internals::BackendProbe probe) {
+    { manager.createEntity() } -> std::same_as<Entity>;
+    { manager.createEntities(size_t{}) } -> std::same_as<std::vector<Entity>>;
+    manager.killEntity(entity);
+    { constManager.alive(entity) } -> std::same_as<bool>;
+    { constManager.template has<internals::BackendProbe>(entity) }
+        -> std::same_as<bool>;
+    { manager.template component<internals::BackendProbe>(entity) }
+        -> std::same_as<internals::BackendProbe&>;
+    { constManager.template component<internals::BackendProbe>(entity) }
+        -> std::same_as<const internals::BackendProbe&>;
+    { manager.template add<internals::BackendProbe>(entity) }
+        -> std::same_as<internals::BackendProbe&>;
+    { manager.add(entity, std::move(probe)) }
+        -> std::same_as<internals::BackendProbe&>;
+    manager.addBatch(entities, probe);
+    manager.template remove<internals::BackendProbe>(entity);
+    manager.template view<internals::BackendProbe>().begin();
+    constManager.template view<internals::BackendProbe>().begin();
+};
+
+} // namespace ge::thing
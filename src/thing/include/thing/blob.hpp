@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace ge::thing::internals {
+
+/**
+ * Writes values and arrays of trivially copyable types as raw bytes, in the
+ * byte order of the machine. Arrays are prefixed with their element count.
+ */
+class BlobWriter {
+public:
+    explicit BlobWriter(std::ostream& stream)
+        : _stream(stream)
+    { }
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    void write(const T& value)
+    {
+        writeBytes(&value, sizeof(T));
+    }
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    void writeArray(std::span<const T> values)
+    {
+        write<uint64_t>(values.size());
+        writeBytes(values.data(), values.size_bytes());
+    }
+
+    void writeBytes(const void* data, size_t size)
+    {
+        _stream.write(
+            static_cast<const char*>(data),
+            static_cast<std::streamsize>(size));
+        if (!_stream) {
+            throw std::runtime_error{
+                "ge::thing::internals::BlobWriter: write failed"};
+        }
+    }
+
+private:
+    std::ostream& _stream;
+};
+
+/**
+ * Like BlobWriter, but appends to a byte buffer, and can patch values it
+ * wrote before. Reusing the buffer avoids allocations once its capacity
+ * suffices.
+ */
+class BufferWriter {
+public:
+    explicit BufferWriter(std::vector<std::byte>& buffer)
+        : _buffer(buffer)
+    { }
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    void write(const T& value)
+    {
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeBytes(const void* data, size_t size)
+    {
+        auto bytes = static_cast<const std::byte*>(data);
+        _buffer.insert(_buffer.end(), bytes, bytes + size);
+    }
+
+    size_t position() const
+    {
+        return _buffer.size();
+    }
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    void patch(size_t position, const T& value)
+    {
+        std::memcpy(_buffer.data() + position, &value, sizeof(T));
+    }
+
+private:
+    std::vector<std::byte>& _buffer;
+};
+
+/**
+ * Reads what BlobWriter wrote, from memory. Throws std::runtime_error if
+ * the data ends early.
+ */
+class BlobReader {
+public:
+    explicit BlobReader(std::span<const std::byte> data)
+        : _data(data)
+    { }
+
+    template <class T>
+        requires std::is_trivially_copyable_v<T>
+    T read()
+    {
+        std::array<std::byte, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), take(sizeof(T)), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+
+    template <class T, class Allocator>
+        requires std::is_trivially_copyable_v<T>
+    void readArray(std::vector<T, Allocator>& values)
+    {
+        auto size = read<uint64_t>();
+        if (size > remaining() / sizeof(T)) {
+            truncated();
+        }
+        // Trivially copyable types need not be default constructible.
+        values.assign(
+            size, std::bit_cast<T>(std::array<std::byte, sizeof(T)>{}));
+        readBytes(values.data(), size * sizeof(T));
+    }
+
+    /**
+     * The element count of the next array, for callers that read the
+     * elements one by one.
+     */
+    size_t readArraySize(size_t elementSize)
+    {
+        auto size = read<uint64_t>();
+        if (size > remaining() / elementSize) {
+            truncated();
+        }
+        return static_cast<size_t>(size);
+    }
+
+    void readBytes(void* data, size_t size)
+    {
+        if (size > 0) {
+            std::memcpy(data, take(size), size);
+        }
+    }
+
+    size_t remaining() const
+    {
+        return _data.size() - _position;
+    }
+
+private:
+    const std::byte* take(size_t size)
+    {
+        if (size > remaining()) {
+            truncated();
+        }
+        auto data = _data.data() + _position;
+        _position += size;
+        return data;
+    }
+
+    [[noreturn]] static void truncated()
+    {
+        throw std::runtime_error{
+            "ge::thing::internals::BlobReader: unexpected end of data"};
+    }
+
+    std::span<const std::byte> _data;
+    size_t _position = 0;
+};
+
+} // namespace ge::thing::internals
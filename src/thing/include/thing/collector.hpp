@@ -0,0 +1,102 @@
+#pragma once
+
+#include <thing/entity.hpp>
+#include <thing/entity_manager.hpp>
+#include <thing/entity_set.hpp>
+#include <thing/hooks.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+namespace ge::thing {
+
+/**
+ * Gathers the entities on which the given events of the component happened,
+ * e.g. to update a spatial index once per frame for just the entities that
+ * were added or moved. Each entity is collected once until clear().
+ *
+ * With Removed among the events, removed entities stay in the collection
+ * and may be dead by the time it is read. Otherwise an entity whose
+ * component is removed leaves the collection again.
+ *
+ * The collector registers hooks with the manager, which must outlive it.
+ */
+template <class Component>
+class Collector {
+public:
+    Collector(
+            EntityManager& manager,
+            std::initializer_list<ComponentEvent> events)
+        : _manager(manager)
+    {
+        auto collect = [this] (Entity entity, const Component&) {
+            _entities.insert(entity);
+        };
+        auto selected = [events] (ComponentEvent event) {
+            return std::find(events.begin(), events.end(), event) !=
+                events.end();
+        };
+        if (selected(ComponentEvent::Added)) {
+            _hooks.push_back(manager.onAdd<Component>(collect));
+        }
+        if (selected(ComponentEvent::Replaced)) {
+            _hooks.push_back(manager.onReplace<Component>(collect));
+        }
+        if (selected(ComponentEvent::Removed)) {
+            _hooks.push_back(manager.onRemove<Component>(collect));
+        } else {
+            _hooks.push_back(manager.onRemove<Component>(
+                [this] (Entity entity, const Component&) {
+                    _entities.erase(entity);
+                }));
+        }
+    }
+
+    Collector(const Collector&) = delete;
+    Collector& operator=(const Collector&) = delete;
+
+    ~Collector()
+    {
+        for (auto id : _hooks) {
+            _manager.removeHook<Component>(id);
+        }
+    }
+
+    /**
+     * The collected entities. Their order is unspecified.
+     */
+    std::span<const Entity> entities() const
+    {
+        return _entities.entities();
+    }
+
+    size_t size() const
+    {
+        return _entities.size();
+    }
+
+    bool empty() const
+    {
+        return _entities.empty();
+    }
+
+    bool contains(Entity entity) const
+    {
+        return _entities.contains(entity);
+    }
+
+    void clear()
+    {
+        _entities.clear();
+    }
+
+private:
+    EntityManager& _manager;
+    std::vector<HookId> _hooks;
+    internals::EntitySet _entities;
+};
+
+} // namespace ge::thing
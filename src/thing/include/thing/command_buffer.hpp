@@ -0,0 +1,340 @@
+#pragma once
+
+#include <thing/component_id.hpp>
+#include <thing/entity.hpp>
+#include <thing/entity_manager.hpp>
+#include <thing/thread_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+namespace internals {
+
+class AbstractCommands {
+public:
+    virtual ~AbstractCommands() {}
+    virtual bool empty() const = 0;
+    virtual void append(AbstractCommands&& other) = 0;
+    virtual void apply(EntityManager& manager) = 0;
+};
+
+template <class Component>
+class Commands final : public AbstractCommands {
+public:
+    void add(Entity entity) requires std::default_initializable<Component>
+    {
+        _commands.push_back({Kind::AddDefault, entity, std::nullopt});
+    }
+
+    void add(Entity entity, Component&& component)
+    {
+        _commands.push_back({Kind::Add, entity, std::move(component)});
+    }
+
+    void remove(Entity entity)
+    {
+        _commands.push_back({Kind::Remove, entity, std::nullopt});
+    }
+
+    bool empty() const override
+    {
+        return _commands.empty();
+    }
+
+    void append(AbstractCommands&& other) override
+    {
+        auto& commands = static_cast<Commands&>(other)._commands;
+        _commands.insert(
+            _commands.end(),
+            std::make_move_iterator(commands.begin()),
+            std::make_move_iterator(commands.end()));
+        commands.clear();
+    }
+
+    void apply(EntityManager& manager) override
+    {
+        // Removals alone do not create the pool.
+        auto pool = manager._components.find<Component>();
+        for (auto& command : _commands) {
+            if (!manager.alive(command.entity)) {
+                continue;
+            }
+            if (!pool && command.kind != Kind::Remove) {
+                pool = &manager._components.create<Component>();
+            }
+            switch (command.kind) {
+                case Kind::Add:
+                    pool->add(command.entity, std::move(*command.value));
+                    break;
+                case Kind::AddDefault:
+                    if constexpr (std::default_initializable<Component>) {
+                        pool->add(command.entity);
+                    }
+                    break;
+                case Kind::Remove:
+                    manager.remove<Component>(command.entity);
+                    break;
+            }
+        }
+        _commands.clear();
+    }
+
+private:
+    enum class Kind {
+        Add,
+        AddDefault,
+        Remove,
+    };
+
+    struct Command {
+        Kind kind;
+        Entity entity;
+        std::optional<Component> value;
+    };
+
+    std::vector<Command> _commands;
+};
+
+} // namespace internals
+
+/**
+ * Records structural changes to be applied to the entity manager later, at a
+ * point where no one is iterating over it.
+ *
+ * Commands are grouped by component type, and applied one pool at a time:
+ * first all new entities are made alive, then the components of each type
+ * are added and removed in the order they were recorded, and the entities
+ * are killed last. Commands for entities that are not alive by then are
+ * skipped. Buffers merged by ThreadCommandBuffers are appended in a fixed
+ * order: those of threads outside any thread pool first, in the order the
+ * threads first recorded, then those of pool workers, by the order the
+ * pools were made, and by worker index within a pool.
+ * Which worker runs a given task is not fixed, so conflicting commands
+ * for the same entity and component should come from the same task.
+ */
+class CommandBuffer {
+public:
+    explicit CommandBuffer(EntityManager& manager)
+        : _manager(manager)
+    { }
+
+    /**
+     * Returns a handle that is valid right away, but the entity only
+     * becomes alive when the buffer is applied.
+     */
+    Entity createEntity()
+    {
+        return _manager.reserveEntity();
+    }
+
+    template <class Component>
+    void add(Entity entity)
+    {
+        commands<Component>().add(entity);
+    }
+
+    template <class Component>
+    void add(Entity entity, Component&& component)
+    {
+        commands<Component>().add(entity, std::move(component));
+    }
+
+    template <class Component>
+    void remove(Entity entity)
+    {
+        commands<Component>().remove(entity);
+    }
+
+    void killEntity(Entity entity)
+    {
+        _killed.push_back(entity);
+    }
+
+    bool empty() const
+    {
+        return _killed.empty() && std::none_of(
+            _commands.begin(), _commands.end(), [] (const auto& commands) {
+                return commands && !commands->empty();
+            });
+    }
+
+    /**
+     * Move the commands of another buffer to the end of this one.
+     */
+    void append(CommandBuffer&& other)
+    {
+        if (_commands.size() < other._commands.size()) {
+            _commands.resize(other._commands.size());
+        }
+        for (size_t id = 0; id < other._commands.size(); id++) {
+            auto& own = _commands[id];
+            auto& commands = other._commands[id];
+            if (!commands) {
+                continue;
+            }
+            if (own) {
+                own->append(std::move(*commands));
+            } else {
+                own = std::move(commands);
+            }
+        }
+        other._commands.clear();
+
+        _killed.insert(
+            _killed.end(), other._killed.begin(), other._killed.end());
+        other._killed.clear();
+    }
+
+    void apply()
+    {
+        _manager.flushReserved();
+        for (auto& commands : _commands) {
+            if (commands) {
+                commands->apply(_manager);
+            }
+        }
+        _commands.clear();
+        _manager.killEntities(_killed);
+        _killed.clear();
+    }
+
+private:
+    template <class Component>
+    internals::Commands<Component>& commands()
+    {
+        auto id = componentId<Component>();
+        if (id >= _commands.size()) {
+            _commands.resize(id + 1);
+        }
+        auto& commands = _commands[id];
+        if (!commands) {
+            commands = std::make_unique<internals::Commands<Component>>();
+        }
+        return static_cast<internals::Commands<Component>&>(*commands);
+    }
+
+    friend class ThreadCommandBuffers;
+
+    EntityManager& _manager;
+    // Indexed by component ID.
+    std::vector<std::unique_ptr<internals::AbstractCommands>> _commands;
+    std::vector<Entity> _killed;
+};
+
+/**
+ * One command buffer per thread, for recording from code that runs on
+ * several threads at once, such as parallelEach(). Each thread finds its
+ * buffer through a thread-local cache, so recording takes no lock once the
+ * thread has its buffer.
+ */
+class ThreadCommandBuffers {
+public:
+    explicit ThreadCommandBuffers(EntityManager& manager)
+        : _manager(manager)
+    { }
+
+    /**
+     * Buffers for the same entity manager as commands, e.g. the buffer
+     * given to a system, which may only have const access to the manager.
+     */
+    explicit ThreadCommandBuffers(CommandBuffer& commands)
+        : _manager(commands._manager)
+    { }
+
+    CommandBuffer& local()
+    {
+        auto& cache = cached();
+        if (cache.owner != _id) {
+            cache.owner = _id;
+            cache.buffer = &add();
+        }
+        return *cache.buffer;
+    }
+
+    /**
+     * Move the commands of all threads into a single buffer, in the order
+     * described for CommandBuffer. Must not be called while other threads
+     * are recording.
+     */
+    CommandBuffer merge()
+    {
+        std::ranges::stable_sort(_buffers, {}, &Slot::order);
+        CommandBuffer merged{_manager};
+        for (auto& slot : _buffers) {
+            merged.append(std::move(*slot.buffer));
+        }
+        _buffers.clear();
+        _id = nextId();
+        return merged;
+    }
+
+    void apply()
+    {
+        merge().apply();
+    }
+
+private:
+    struct Slot {
+        // Threads outside any pool come first, then workers by pool ID and
+        // worker index.
+        std::pair<size_t, size_t> order;
+        std::thread::id thread;
+        std::unique_ptr<CommandBuffer> buffer;
+    };
+
+    // The buffer the thread used last, and the ID of its owner. IDs are
+    // never reused, and a merge gives the owner a new one, so a stale
+    // cache never matches.
+    struct Cache {
+        uint64_t owner = 0;
+        CommandBuffer* buffer = nullptr;
+    };
+
+    static Cache& cached()
+    {
+        thread_local Cache cache;
+        return cache;
+    }
+
+    static uint64_t nextId()
+    {
+        static std::atomic<uint64_t> id = 0;
+        return ++id;
+    }
+
+    // Find or make the buffer of the calling thread, after a cache miss.
+    CommandBuffer& add()
+    {
+        auto thread = std::this_thread::get_id();
+        std::lock_guard lock{_mutex};
+        auto slot = std::ranges::find(_buffers, thread, &Slot::thread);
+        if (slot != _buffers.end()) {
+            return *slot->buffer;
+        }
+        auto worker = ThreadPool::currentWorker();
+        auto order = worker.pool ?
+            std::pair{worker.pool->id() + 1, worker.index} :
+            std::pair{size_t{0}, size_t{0}};
+        _buffers.push_back(
+            {order, thread, std::make_unique<CommandBuffer>(_manager)});
+        return *_buffers.back().buffer;
+    }
+
+    EntityManager& _manager;
+    uint64_t _id = nextId();
+    std::mutex _mutex;
+    std::vector<Slot> _buffers;
+};
+
+} // namespace ge::thing
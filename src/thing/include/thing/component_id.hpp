@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace ge::thing {
+
+/**
+ * Sequential identifier of a component type, assigned on first use. IDs are
+ * small and dense, so they can index flat arrays. They are only stable
+ * within one run of the program.
+ */
+using ComponentId = size_t;
+
+namespace internals {
+
+inline ComponentId nextComponentId()
+{
+    static std::atomic<ComponentId> next = 0;
+    return next++;
+}
+
+template <class Component>
+struct ComponentIdOf {
+    static ComponentId value()
+    {
+        static const ComponentId id = nextComponentId();
+        return id;
+    }
+};
+
+} // namespace internals
+
+template <class Component>
+ComponentId componentId()
+{
+    return internals::ComponentIdOf<std::remove_cv_t<Component>>::value();
+}
+
+} // namespace ge::thing
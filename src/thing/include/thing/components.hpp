@@ -0,0 +1,1903 @@
+#pragma once
+
+#include <thing/blob.hpp>
+#include <thing/component_id.hpp>
+#include <thing/entity.hpp>
+#include <thing/hooks.hpp>
+#include <thing/registry.hpp>
+#include <thing/statistics.hpp>
+#include <thing/storage.hpp>
+#include <thing/tick.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+/**
+ * Order in which OneTypeComponents::gather() reads the components: that of
+ * the entities, or that of the pool.
+ */
+enum class GatherOrder {
+    Input,
+    Dense,
+};
+
+} // namespace ge::thing
+
+namespace ge::thing::internals {
+
+/**
+ * Maps entity slot indices to dense indices. The sparse side is split into
+ * fixed-size pages, which are only allocated for slot ranges that are
+ * actually used. Generations are not checked here; the owner of the dense
+ * array does that.
+ */
+class SparseIndex {
+public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    explicit SparseIndex(
+            std::pmr::memory_resource* resource =
+                std::pmr::get_default_resource())
+        : _pages(resource)
+    { }
+
+    size_t find(Entity entity) const
+    {
+        auto [page, offset] = position(entity);
+        if (page >= _pages.size() || _pages[page].empty()) {
+            return npos;
+        }
+        auto index = _pages[page][offset];
+        return index == Empty ? npos : index;
+    }
+
+    size_t at(Entity entity) const
+    {
+        auto index = find(entity);
+        if (index == npos) {
+            throw std::out_of_range{"ge::thing::internals::SparseIndex::at"};
+        }
+        return index;
+    }
+
+    bool contains(Entity entity) const
+    {
+        return find(entity) != npos;
+    }
+
+    // Prefetch the entry of the entity, if its page exists.
+    void prefetch(Entity entity) const
+    {
+        auto [page, offset] = position(entity);
+        if (page < _pages.size() && !_pages[page].empty()) {
+            internals::prefetch(&_pages[page][offset]);
+        }
+    }
+
+    void set(Entity entity, size_t index)
+    {
+        auto [page, offset] = position(entity);
+        if (page >= _pages.size()) {
+            _pages.resize(page + 1);
+        }
+        if (_pages[page].empty()) {
+            _pages[page].resize(PageSize, Empty);
+        }
+        _pages[page][offset] = static_cast<IndexType>(index);
+    }
+
+    void erase(Entity entity)
+    {
+        auto [page, offset] = position(entity);
+        if (page < _pages.size() && !_pages[page].empty()) {
+            _pages[page][offset] = Empty;
+        }
+    }
+
+    void save(BlobWriter& writer) const
+    {
+        writer.write<uint64_t>(_pages.size());
+        for (const auto& page : _pages) {
+            writer.writeArray<IndexType>(page);
+        }
+    }
+
+    /**
+     * Read what save() wrote for the dense array of entities, and check in
+     * the same pass that the entries and the entities agree.
+     */
+    void load(BlobReader& reader, std::span<const Entity> entities)
+    {
+        _pages.clear();
+        _pages.resize(reader.readArraySize(sizeof(uint64_t)));
+        size_t count = 0;
+        for (size_t page = 0; page < _pages.size(); page++) {
+            auto& entries = _pages[page];
+            reader.readArray(entries);
+            if (!entries.empty() && entries.size() != PageSize) {
+                badIndex("bad page");
+            }
+            for (size_t offset = 0; offset < entries.size(); offset++) {
+                auto index = entries[offset];
+                if (index == Empty) {
+                    continue;
+                }
+                if (index >= entities.size() ||
+                        entities[index].index() !=
+                            page * PageSize + offset) {
+                    badIndex("entry does not match the entities");
+                }
+                ++count;
+            }
+        }
+        if (count != entities.size()) {
+            badIndex("entities are missing");
+        }
+    }
+
+    /**
+     * Upper bound for the slot indices in the index, and the dense index
+     * stored for a slot, or npos.
+     */
+    size_t slotCount() const
+    {
+        return _pages.size() * PageSize;
+    }
+
+    size_t findSlot(size_t slot) const
+    {
+        const auto& page = _pages[slot / PageSize];
+        if (page.empty()) {
+            return npos;
+        }
+        auto index = page[slot % PageSize];
+        return index == Empty ? npos : index;
+    }
+
+    /**
+     * Release pages with no entries, from the given one on. Checking a page
+     * takes PageSize units off the budget. Returns true once all pages are
+     * checked.
+     */
+    bool releasePages(size_t& page, size_t& budget)
+    {
+        for (; budget > 0 && page < _pages.size(); page++) {
+            budget -= std::min(budget, PageSize);
+            releaseIfEmpty(_pages[page]);
+        }
+        return page >= _pages.size();
+    }
+
+    /**
+     * Drop trailing empty pages, and release the unused capacity of the
+     * page array.
+     */
+    void trimPages()
+    {
+        while (!_pages.empty() && _pages.back().empty()) {
+            _pages.pop_back();
+        }
+        _pages.shrink_to_fit();
+    }
+
+    size_t memory() const
+    {
+        auto bytes = _pages.capacity() * sizeof(_pages[0]);
+        for (const auto& page : _pages) {
+            bytes += page.capacity() * sizeof(IndexType);
+        }
+        return bytes;
+    }
+
+private:
+    using IndexType = uint32_t;
+
+    static constexpr size_t PageSize = 4096;
+    static constexpr IndexType Empty = std::numeric_limits<IndexType>::max();
+
+    static std::pair<size_t, size_t> position(Entity entity)
+    {
+        auto index = entity.index();
+        return {
+            static_cast<size_t>(index / PageSize),
+            static_cast<size_t>(index % PageSize)};
+    }
+
+    [[noreturn]] static void badIndex(const char* reason)
+    {
+        throw std::runtime_error{
+            std::string{"ge::thing::internals::SparseIndex::load: "} +
+            reason};
+    }
+
+    static void releaseIfEmpty(std::pmr::vector<IndexType>& page)
+    {
+        if (!page.empty() && std::all_of(
+                page.begin(), page.end(), [] (auto index) {
+                    return index == Empty;
+                })) {
+            page = std::pmr::vector<IndexType>{page.get_allocator()};
+        }
+    }
+
+    std::pmr::vector<std::pmr::vector<IndexType>> _pages;
+};
+
+class AnyTypeComponents;
+
+/**
+ * Progress of an incremental compaction of one pool.
+ */
+struct PoolCompaction {
+    size_t slot = 0;
+    size_t position = 0;
+    // Next index page to check, and next array to shrink.
+    size_t page = 0;
+    size_t array = 0;
+};
+
+class AbstractComponents {
+public:
+    virtual ~AbstractComponents() {}
+    virtual void killEntity(Entity entity) = 0;
+    virtual void copyEntity(Entity source, std::span<const Entity> targets) = 0;
+    virtual PoolStatistics statistics() const = 0;
+    virtual bool compact(PoolCompaction& state, size_t& budget) = 0;
+    virtual void moveHooks(AnyTypeComponents& target) = 0;
+    virtual void cloneInto(AnyTypeComponents& target) const = 0;
+    virtual void moveEntities(
+        std::span<const Entity> sources,
+        AnyTypeComponents& target,
+        std::span<const Entity> destinations) = 0;
+
+    // Access by address, for components handled by ID. Values are added by
+    // moving them from the given address, or default-constructed if it is
+    // null.
+    virtual bool contains(Entity entity) const = 0;
+    virtual std::span<const Entity> entities() const = 0;
+    virtual void markChanged(Entity entity) = 0;
+    virtual void* addRaw(Entity entity, void* value) = 0;
+    // Null if the entity does not have the component.
+    virtual const void* findRaw(Entity entity) const = 0;
+    // The components in the order of entities(), or null if they are not
+    // stored contiguously.
+    virtual const void* rawData() const = 0;
+
+    /**
+     * Guards the pool while access tokens of the entity manager use it.
+     */
+    std::shared_mutex& mutex() const
+    {
+        return _mutex;
+    }
+
+private:
+    mutable std::shared_mutex _mutex;
+};
+
+/**
+ * Keeps several pools in the same dense order for the entities they share.
+ * A pool is owned by at most one group, which it notifies when entities are
+ * added to it, and before they are removed from it.
+ */
+class AbstractGroup {
+public:
+    virtual ~AbstractGroup() {}
+    virtual void added(Entity entity) = 0;
+    virtual void removing(Entity entity) = 0;
+    virtual void cloneInto(AnyTypeComponents& target) const = 0;
+    virtual void createPools(AnyTypeComponents& target) const = 0;
+    virtual void moveTo(AnyTypeComponents& target) = 0;
+};
+
+template <class Component>
+class OneTypeComponents final : public AbstractComponents {
+public:
+    using Policy = StoragePolicy<Component>;
+    using Storage = typename StorageFor<Component>::Type;
+    // Component& or, for columnar storage, a proxy.
+    using Reference = typename Storage::Reference;
+    using ConstReference = typename Storage::ConstReference;
+
+    static constexpr bool isSingleton =
+        std::is_same_v<Policy, storage::Singleton>;
+
+    // A tag has no data that could change, so tag pools keep no changed
+    // ticks; the added tick serves as both.
+    static constexpr bool tracksChanges =
+        !std::is_same_v<Policy, storage::Tag>;
+
+    explicit OneTypeComponents(
+            std::shared_ptr<const Clock> clock = std::make_shared<Clock>(),
+            std::pmr::memory_resource* resource =
+                std::pmr::get_default_resource())
+        : _clock(std::move(clock))
+        , _components(resource)
+        , _entities(resource)
+        , _entityIndex(resource)
+        , _addedTicks(resource)
+        , _changedTicks(resource)
+        , _chunkTicks(resource)
+    { }
+
+    bool contains(Entity entity) const override
+    {
+        return find(entity) != SparseIndex::npos;
+    }
+
+    size_t find(Entity entity) const
+    {
+        if constexpr (isSingleton) {
+            return !_entities.empty() && _entities[0] == entity ?
+                0 : SparseIndex::npos;
+        } else {
+            auto index = _entityIndex.find(entity);
+            if (index == SparseIndex::npos || _entities[index] != entity) {
+                return SparseIndex::npos;
+            }
+            return index;
+        }
+    }
+
+    size_t size() const
+    {
+        return _entities.size();
+    }
+
+    ConstReference component(Entity entity) const
+    {
+        return _components[at(entity)];
+    }
+
+    /**
+     * Mutable access marks the component as changed at the current tick.
+     */
+    Reference component(Entity entity)
+    {
+        return componentAt(at(entity));
+    }
+
+    /**
+     * Component by its position in the dense order, i.e. the position of
+     * its entity in entities().
+     */
+    ConstReference componentAt(size_t index) const
+    {
+        return _components[index];
+    }
+
+    Reference componentAt(size_t index)
+    {
+        markChanged(index);
+        return _components[index];
+    }
+
+    std::span<const Component> components() const
+        requires Storage::contiguous
+    {
+        return _components.span();
+    }
+
+    /**
+     * Mutable span of all components. Writes through the span are not
+     * tracked; use markChanged() for the entries that were modified.
+     */
+    std::span<Component> components() requires Storage::contiguous
+    {
+        return _components.span();
+    }
+
+    /**
+     * One field of every component, in the dense order, for columnar
+     * storage. Writes through the span are not tracked.
+     */
+    template <auto Field>
+    auto column() const requires std::same_as<Policy, storage::Columns>
+    {
+        return _components.template column<Field>();
+    }
+
+    template <auto Field>
+    auto column() requires std::same_as<Policy, storage::Columns>
+    {
+        return _components.template column<Field>();
+    }
+
+    /**
+     * Copy the components of the entities into out, in the same order,
+     * e.g. for the targets or neighbours that a system keeps in a list.
+     * Lookups run ahead of the copies and prefetch the index and component
+     * memory, so that their cache misses overlap. GatherOrder::Dense sorts
+     * the lookups and reads the components in pool order instead, which
+     * can pay off for large components; inputs of more than 2^32
+     * entities are read in input order. Throws std::invalid_argument if
+     * out has another size than entities, and std::out_of_range if an
+     * entity does not have the component.
+     */
+    void gather(
+        std::span<const Entity> entities,
+        std::span<Component> out,
+        GatherOrder order = GatherOrder::Input) const
+    {
+        if (out.size() != entities.size()) {
+            throw std::invalid_argument{
+                "ge::thing::internals::OneTypeComponents::gather: "
+                "output size mismatch"};
+        }
+        if (order == GatherOrder::Dense &&
+                entities.size() <= MaxDenseGather) {
+            gatherDense(entities, out);
+            return;
+        }
+
+        // Entries are looked up Distance entities ahead of the copies, and
+        // their index pages prefetched twice as far ahead.
+        constexpr size_t Distance = 8;
+        std::array<size_t, Distance> ahead;
+        auto count = entities.size();
+        auto lookup = [&] (size_t i) {
+            if (i + Distance < count) {
+                prefetchSlot(entities[i + Distance]);
+            }
+            auto index = slot(entities[i]);
+            if (index != SparseIndex::npos) {
+                internals::prefetch(&_entities[index]);
+                _components.prefetch(index);
+            }
+            ahead[i % Distance] = index;
+        };
+
+        for (size_t i = 0; i < std::min(count, Distance); i++) {
+            prefetchSlot(entities[i]);
+        }
+        for (size_t i = 0; i < std::min(count, Distance); i++) {
+            lookup(i);
+        }
+        for (size_t i = 0; i < count; i++) {
+            auto index = ahead[i % Distance];
+            if (i + Distance < count) {
+                lookup(i + Distance);
+            }
+            checkGathered(entities[i], index);
+            out[i] = _components[index];
+        }
+    }
+
+    std::span<const Entity> entities() const override
+    {
+        return _entities;
+    }
+
+    /**
+     * Ticks at which the component at the dense index was added and last
+     * changed.
+     */
+    Tick addedTick(size_t index) const
+    {
+        return _addedTicks[index];
+    }
+
+    Tick changedTick(size_t index) const
+    {
+        if constexpr (tracksChanges) {
+            return _changedTicks[index];
+        } else {
+            return _addedTicks[index];
+        }
+    }
+
+    /**
+     * Upper bound for the changed ticks of all components in a chunk of
+     * TickChunkSize dense entries. Chunks with a tick not newer than the
+     * one a reader is interested in can be skipped as a whole.
+     */
+    Tick chunkTick(size_t chunk) const
+    {
+        return std::atomic_ref{_chunkTicks[chunk]}.load(
+            std::memory_order_relaxed);
+    }
+
+    /**
+     * Stamp the component at the dense index as changed. Safe to call
+     * concurrently for different indices with the same tick. Does nothing
+     * for tags.
+     */
+    void markChanged(size_t index, Tick tick)
+    {
+        if constexpr (tracksChanges) {
+            _changedTicks[index] = tick;
+            raiseChunkTick(index / TickChunkSize, tick);
+        }
+    }
+
+    void markChanged(size_t index)
+    {
+        markChanged(index, tick());
+    }
+
+    void markChanged(Entity entity) override
+    {
+        markChanged(at(entity));
+    }
+
+    Tick tick() const
+    {
+        return _clock->tick.load(std::memory_order_relaxed);
+    }
+
+    Reference add(Entity entity) requires std::default_initializable<Component>
+    {
+        if (auto index = find(entity); index != SparseIndex::npos) {
+            return componentAt(index);
+        }
+        return push(entity);
+    }
+
+    Reference add(Entity entity, Component&& component)
+    {
+        if (auto index = find(entity); index != SparseIndex::npos) {
+            Reference ref = _components[index];
+            ref = std::move(component);
+            markChanged(index);
+            notify(ComponentEvent::Replaced, entity, ref);
+            return ref;
+        }
+        return push(entity, std::move(component));
+    }
+
+    void reserve(size_t capacity)
+    {
+        _components.reserve(capacity);
+        _entities.reserve(capacity);
+        _addedTicks.reserve(capacity);
+        if constexpr (tracksChanges) {
+            _changedTicks.reserve(capacity);
+        }
+    }
+
+    /**
+     * Add a component to each entity. Capacity is reserved once for the
+     * whole batch, growing geometrically as single adds do. Entities that
+     * already have the component get the new value assigned.
+     */
+    void addBatch(
+        std::span<const Entity> entities,
+        std::span<const Component> components)
+    {
+        grow(entities.size());
+        for (size_t i = 0; i < entities.size(); i++) {
+            addCopy(entities[i], components[i]);
+        }
+    }
+
+    void addBatch(std::span<const Entity> entities, const Component& component)
+    {
+        grow(entities.size());
+        for (auto entity : entities) {
+            addCopy(entity, component);
+        }
+    }
+
+    /**
+     * Write the pool as raw arrays: entities, components, ticks, and the
+     * sparse index. Only for trivially copyable components.
+     */
+    void save(BlobWriter& writer) const
+        requires std::is_trivially_copyable_v<Component>
+    {
+        writer.writeArray<Entity>(_entities);
+        _components.save(writer);
+        writer.writeArray<Tick>(_addedTicks);
+        if constexpr (tracksChanges) {
+            writer.writeArray<Tick>(_changedTicks);
+        }
+        writer.writeArray<Tick>(_chunkTicks);
+        if constexpr (!isSingleton) {
+            _entityIndex.save(writer);
+        }
+    }
+
+    /**
+     * Replace the contents of the pool with what save() wrote. The arrays
+     * are copied as they are; their sizes are checked, and so is every
+     * entry of the index against the entities.
+     */
+    void load(BlobReader& reader)
+        requires std::is_trivially_copyable_v<Component>
+    {
+        reader.readArray(_entities);
+        _components.load(reader);
+        reader.readArray(_addedTicks);
+        if constexpr (tracksChanges) {
+            reader.readArray(_changedTicks);
+        }
+        reader.readArray(_chunkTicks);
+        if constexpr (!isSingleton) {
+            _entityIndex.load(reader, _entities);
+        }
+
+        auto size = _entities.size();
+        if (_components.size() != size ||
+                _addedTicks.size() != size ||
+                (tracksChanges && _changedTicks.size() != size) ||
+                _chunkTicks.size() !=
+                    (size + TickChunkSize - 1) / TickChunkSize ||
+                (isSingleton && size > 1)) {
+            throw std::runtime_error{
+                "ge::thing::internals::OneTypeComponents::load: "
+                "inconsistent pool"};
+        }
+    }
+
+    /**
+     * Swap two entries of the dense order, together with their ticks.
+     */
+    void swapEntries(size_t lhs, size_t rhs)
+    {
+        if (lhs == rhs) {
+            return;
+        }
+        _components.swap(lhs, rhs);
+        std::swap(_entities[lhs], _entities[rhs]);
+        std::swap(_addedTicks[lhs], _addedTicks[rhs]);
+        if constexpr (tracksChanges) {
+            std::swap(_changedTicks[lhs], _changedTicks[rhs]);
+        }
+        if constexpr (!isSingleton) {
+            _entityIndex.set(_entities[lhs], lhs);
+            _entityIndex.set(_entities[rhs], rhs);
+        }
+        raiseChunkTick(lhs / TickChunkSize, changedTick(lhs));
+        raiseChunkTick(rhs / TickChunkSize, changedTick(rhs));
+    }
+
+    /**
+     * Reorder the dense arrays in place. The comparator takes either two
+     * components, or two entities.
+     */
+    template <class Compare>
+    void sort(Compare compare)
+    {
+        std::vector<size_t> order(_entities.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::sort(
+            order.begin(), order.end(), [this, &compare] (auto lhs, auto rhs) {
+                if constexpr (std::invocable<
+                        Compare&, const Component&, const Component&>) {
+                    return compare(
+                        std::as_const(_components)[lhs],
+                        std::as_const(_components)[rhs]);
+                } else {
+                    return compare(_entities[lhs], _entities[rhs]);
+                }
+            });
+
+        // Entry i takes the old entry order[i]; follow each cycle of the
+        // permutation, swapping entries along it.
+        for (size_t first = 0; first < order.size(); first++) {
+            auto current = first;
+            auto next = order[current];
+            while (next != first) {
+                swapEntries(current, next);
+                order[current] = current;
+                current = next;
+                next = order[current];
+            }
+            order[current] = current;
+        }
+    }
+
+    /**
+     * Move entries into the order of their entity slots, then release
+     * unused capacity. Does at most budget units of work, taking them off
+     * the budget, and returns true once finished. Shrinking an array may
+     * move all of its elements, so it takes the rest of the budget: a call
+     * reallocates at most one array, or the component storage. The pool
+     * stays valid between calls, and changes to it only make the order
+     * less perfect. Pools owned by a group keep their order.
+     */
+    bool compact(PoolCompaction& state, size_t& budget) override
+    {
+        if constexpr (!isSingleton) {
+            if (!_group) {
+                auto slots = _entityIndex.slotCount();
+                while (budget > 0 && state.slot < slots) {
+                    --budget;
+                    auto index = _entityIndex.findSlot(state.slot++);
+                    if (index != SparseIndex::npos &&
+                            index >= state.position) {
+                        swapEntries(state.position++, index);
+                    }
+                }
+                if (state.slot < slots) {
+                    return false;
+                }
+            }
+            if (!_entityIndex.releasePages(state.page, budget)) {
+                return false;
+            }
+        }
+        if (budget == 0) {
+            return false;
+        }
+        budget = 0;
+        switch (state.array++) {
+            case 0:
+                _components.shrinkToFit();
+                return false;
+            case 1:
+                _entities.shrink_to_fit();
+                return false;
+            case 2:
+                _addedTicks.shrink_to_fit();
+                return false;
+            case 3:
+                _changedTicks.shrink_to_fit();
+                return false;
+            case 4:
+                _chunkTicks.shrink_to_fit();
+                return false;
+            default:
+                if constexpr (!isSingleton) {
+                    _entityIndex.trimPages();
+                }
+                return true;
+        }
+    }
+
+    PoolStatistics statistics() const override
+    {
+        PoolStatistics statistics;
+        statistics.component = componentId<Component>();
+        statistics.size = size();
+        statistics.capacity = _components.capacity();
+        statistics.componentBytes = _components.memory();
+        statistics.indexBytes = _entityIndex.memory() +
+            _entities.capacity() * sizeof(Entity) +
+            (_addedTicks.capacity() + _changedTicks.capacity() +
+                _chunkTicks.capacity()) * sizeof(Tick);
+
+        // Live data: components, entities, their ticks, and index entries.
+        auto componentSize = tracksChanges ? sizeof(Component) : 0;
+        auto tickSize = (tracksChanges ? 2 : 1) * sizeof(Tick);
+        auto indexSize = isSingleton ? 0 : sizeof(uint32_t);
+        auto live = size() *
+            (componentSize + sizeof(Entity) + tickSize + indexSize);
+        auto total = statistics.totalBytes();
+        statistics.fragmentation = total == 0 ?
+            0 : 1 - static_cast<double>(std::min(live, total)) /
+                static_cast<double>(total);
+        return statistics;
+    }
+
+    AbstractGroup* group() const
+    {
+        return _group;
+    }
+
+    bool hooked() const
+    {
+        return _hooks != nullptr;
+    }
+
+    /**
+     * Register a function called on the event, with the entity and its
+     * component. Hooks must not make structural changes to the pool, and
+     * replacing values is the only change they may make to other pools.
+     * Without hooks, the events cost a null pointer test.
+     */
+    HookId addHook(
+        ComponentEvent event,
+        typename ComponentHooks<Component>::Hook hook)
+    {
+        if (!_hooks) {
+            _hooks = std::make_unique<ComponentHooks<Component>>();
+        }
+        return _hooks->add(event, std::move(hook));
+    }
+
+    void removeHook(HookId id)
+    {
+        if (_hooks) {
+            _hooks->remove(id);
+            if (_hooks->empty()) {
+                _hooks.reset();
+            }
+        }
+    }
+
+    void moveHooks(AnyTypeComponents& target) override;
+
+    /**
+     * Columnar components have no address: the raw access throws
+     * std::logic_error for them.
+     */
+    void* addRaw(Entity entity, void* value) override
+    {
+        checkAddressable();
+        if constexpr (!std::same_as<Policy, storage::Columns>) {
+            if (value) {
+                if constexpr (std::move_constructible<Component>) {
+                    return &add(
+                        entity, std::move(*static_cast<Component*>(value)));
+                }
+            } else if constexpr (std::default_initializable<Component>) {
+                return &add(entity);
+            }
+        }
+        throw std::logic_error{
+            "ge::thing::internals::OneTypeComponents::addRaw: "
+            "component cannot be constructed so"};
+    }
+
+    const void* findRaw(Entity entity) const override
+    {
+        checkAddressable();
+        if constexpr (!std::same_as<Policy, storage::Columns>) {
+            auto index = find(entity);
+            if (index != SparseIndex::npos) {
+                return &_components[index];
+            }
+        }
+        return nullptr;
+    }
+
+    const void* rawData() const override
+    {
+        if constexpr (Storage::contiguous) {
+            return _components.span().data();
+        } else {
+            return nullptr;
+        }
+    }
+
+    void setGroup(AbstractGroup* group)
+    {
+        _group = group;
+    }
+
+    void copyEntity(Entity source, std::span<const Entity> targets) override
+    {
+        auto index = find(source);
+        if (index == SparseIndex::npos) {
+            return;
+        }
+        if constexpr (std::copy_constructible<Component>) {
+            // Copy first: the batch may reallocate the source.
+            Component component = _components[index];
+            addBatch(targets, component);
+        } else {
+            throw std::logic_error{
+                "ge::thing::internals::OneTypeComponents::copyEntity: "
+                "component is not copyable"};
+        }
+    }
+
+    void killEntity(Entity entity) override
+    {
+        auto index = find(entity);
+        if (index == SparseIndex::npos) {
+            return;
+        }
+        if (_hooks) {
+            notify(ComponentEvent::Removed, entity, _components[index]);
+        }
+        erase(entity, index);
+    }
+
+    /**
+     * Copy the entries, but neither the hooks nor the group, into a new
+     * pool of the target, which must not have one yet.
+     */
+    void cloneInto(AnyTypeComponents& target) const override;
+
+    /**
+     * Move the components of the sources to the destinations in the pool
+     * of the target, as if they were removed here and added there.
+     */
+    void moveEntities(
+        std::span<const Entity> sources,
+        AnyTypeComponents& target,
+        std::span<const Entity> destinations) override;
+
+private:
+    void erase(Entity entity, size_t index)
+    {
+        if (_group) {
+            _group->removing(entity);
+            index = find(entity);
+        }
+
+        Entity lastEntity = _entities.back();
+        if (index != _entities.size() - 1) {
+            _entities[index] = lastEntity;
+            _addedTicks[index] = _addedTicks.back();
+            if constexpr (tracksChanges) {
+                _changedTicks[index] = _changedTicks.back();
+            }
+            raiseChunkTick(index / TickChunkSize, changedTick(index));
+            if constexpr (!isSingleton) {
+                _entityIndex.set(lastEntity, index);
+            }
+        }
+        if constexpr (!isSingleton) {
+            _entityIndex.erase(entity);
+        }
+        _entities.pop_back();
+        _addedTicks.pop_back();
+        if constexpr (tracksChanges) {
+            _changedTicks.pop_back();
+        }
+        _chunkTicks.resize(
+            (_entities.size() + TickChunkSize - 1) / TickChunkSize);
+        _components.swapRemove(index);
+    }
+
+    template <class... Args>
+    Reference push(Entity entity, Args&&... args)
+    {
+        if constexpr (isSingleton) {
+            if (!_entities.empty()) {
+                throw std::logic_error{
+                    "ge::thing::internals::OneTypeComponents::push: "
+                    "singleton component already exists"};
+            }
+        }
+
+        Reference component =
+            _components.emplace(std::forward<Args>(args)...);
+        if constexpr (!isSingleton) {
+            _entityIndex.set(entity, _entities.size());
+        }
+        _entities.push_back(entity);
+
+        auto tick = this->tick();
+        _addedTicks.push_back(tick);
+        if constexpr (tracksChanges) {
+            _changedTicks.push_back(tick);
+        }
+        auto chunk = (_entities.size() - 1) / TickChunkSize;
+        if (chunk == _chunkTicks.size()) {
+            _chunkTicks.push_back(tick);
+        } else {
+            raiseChunkTick(chunk, tick);
+        }
+
+        if (_group) {
+            // The group may move the new entry.
+            _group->added(entity);
+            Reference moved = _components[find(entity)];
+            notify(ComponentEvent::Added, entity, moved);
+            return moved;
+        }
+        notify(ComponentEvent::Added, entity, component);
+        return component;
+    }
+
+    // Takes a reference of the storage so that columnar components are only
+    // gathered into a value when there are hooks.
+    template <class Value>
+    void notify(ComponentEvent event, Entity entity, const Value& value)
+    {
+        if (!_hooks) {
+            return;
+        }
+        if constexpr (std::is_reference_v<Reference>) {
+            _hooks->notify(event, entity, value);
+        } else {
+            _hooks->notify(event, entity, Component(value));
+        }
+    }
+
+    void raiseChunkTick(size_t chunk, Tick tick)
+    {
+        auto chunkTick = std::atomic_ref{_chunkTicks[chunk]};
+        if (chunkTick.load(std::memory_order_relaxed) < tick) {
+            chunkTick.store(tick, std::memory_order_relaxed);
+        }
+    }
+
+    // Make room for count more components. An exact reserve per batch
+    // would reallocate the pool on every call of a steady stream of small
+    // batches.
+    void grow(size_t count)
+    {
+        auto size = _entities.size() + count;
+        if (size > _entities.capacity()) {
+            reserve(std::max(size, 2 * _entities.capacity()));
+        }
+    }
+
+    void addCopy(Entity entity, const Component& component)
+    {
+        if (auto index = find(entity); index != SparseIndex::npos) {
+            _components[index] = component;
+            markChanged(index);
+            notify(ComponentEvent::Replaced, entity, _components[index]);
+            return;
+        }
+        push(entity, component);
+    }
+
+    // The dense index that the index holds for the slot of the entity,
+    // which may belong to another generation.
+    size_t slot(Entity entity) const
+    {
+        if constexpr (isSingleton) {
+            return _entities.empty() ? SparseIndex::npos : 0;
+        } else {
+            return _entityIndex.find(entity);
+        }
+    }
+
+    void prefetchSlot(Entity entity) const
+    {
+        if constexpr (!isSingleton) {
+            _entityIndex.prefetch(entity);
+        }
+    }
+
+    static void checkAddressable()
+    {
+        if constexpr (std::same_as<Policy, storage::Columns>) {
+            throw std::logic_error{
+                "ge::thing::internals::OneTypeComponents: "
+                "columnar components have no address"};
+        }
+    }
+
+    void checkGathered(Entity entity, size_t index) const
+    {
+        if (index == SparseIndex::npos || _entities[index] != entity) {
+            throw std::out_of_range{
+                "ge::thing::internals::OneTypeComponents::gather"};
+        }
+    }
+
+    // Input positions must fit in the low half of a gatherDense() key;
+    // gather() reads larger inputs in input order.
+    static constexpr uint64_t MaxDenseGather = uint64_t{1} << 32;
+
+    void gatherDense(
+        std::span<const Entity> entities,
+        std::span<Component> out) const
+    {
+        constexpr size_t Distance = 16;
+
+        // Dense index in the high half of a key, position in the input in
+        // the low half, so that sorting the keys sorts the accesses.
+        std::vector<uint64_t> accesses;
+        accesses.reserve(entities.size());
+        for (size_t i = 0; i < entities.size(); i++) {
+            if (i + Distance < entities.size()) {
+                prefetchSlot(entities[i + Distance]);
+            }
+            auto index = slot(entities[i]);
+            if (index == SparseIndex::npos) {
+                checkGathered(entities[i], index);
+            }
+            accesses.push_back(static_cast<uint64_t>(index) << 32 | i);
+        }
+        sortAccesses(accesses);
+        for (auto access : accesses) {
+            auto index = static_cast<size_t>(access >> 32);
+            auto position = static_cast<size_t>(access & 0xffffffff);
+            checkGathered(entities[position], index);
+            out[position] = _components[index];
+        }
+    }
+
+    // Radix sort of the keys by dense index, with as many passes as the
+    // size of the pool needs.
+    void sortAccesses(std::vector<uint64_t>& accesses) const
+    {
+        constexpr unsigned DigitBits = 11;
+        constexpr uint64_t DigitMask = (uint64_t{1} << DigitBits) - 1;
+
+        auto indexes = static_cast<uint64_t>(size());
+        std::vector<uint64_t> sorted(accesses.size());
+        std::array<size_t, DigitMask + 1> offsets;
+        for (unsigned shift = 32;
+                shift < 64 && (indexes >> (shift - 32)) != 0;
+                shift += DigitBits) {
+            offsets.fill(0);
+            for (auto access : accesses) {
+                ++offsets[(access >> shift) & DigitMask];
+            }
+            size_t offset = 0;
+            for (auto& count : offsets) {
+                offset += std::exchange(count, offset);
+            }
+            for (auto access : accesses) {
+                sorted[offsets[(access >> shift) & DigitMask]++] = access;
+            }
+            accesses.swap(sorted);
+        }
+    }
+
+    size_t at(Entity entity) const
+    {
+        auto index = find(entity);
+        if (index == SparseIndex::npos) {
+            throw std::out_of_range{
+                "ge::thing::internals::OneTypeComponents::at"};
+        }
+        return index;
+    }
+
+    std::shared_ptr<const Clock> _clock;
+    AbstractGroup* _group = nullptr;
+    Storage _components;
+    std::pmr::vector<Entity> _entities;
+    SparseIndex _entityIndex;
+    std::pmr::vector<Tick> _addedTicks;
+    std::pmr::vector<Tick> _changedTicks;
+    mutable std::pmr::vector<Tick> _chunkTicks;
+    std::unique_ptr<ComponentHooks<Component>> _hooks;
+};
+
+/**
+ * Owning group: the entities that have all of the components come first in
+ * every owned pool, in the same order. Entities are moved in and out of the
+ * shared prefix as the pools notify the group of changes.
+ */
+template <class... Owned>
+class OwningGroup final : public AbstractGroup {
+public:
+    explicit OwningGroup(OneTypeComponents<Owned>&... pools)
+        : _pools(&pools...)
+    {
+        build();
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    template <class Component>
+    OneTypeComponents<Component>& pool() const
+    {
+        return *std::get<OneTypeComponents<Component>*>(_pools);
+    }
+
+    void added(Entity entity) override
+    {
+        auto index = std::get<0>(_pools)->find(entity);
+        if (index < _size ||
+                !std::apply([entity] (auto*... pools) {
+                    return (... && pools->contains(entity));
+                }, _pools)) {
+            return;
+        }
+        std::apply([this, entity] (auto*... pools) {
+            (pools->swapEntries(pools->find(entity), _size), ...);
+        }, _pools);
+        ++_size;
+    }
+
+    void cloneInto(AnyTypeComponents& target) const override;
+    void createPools(AnyTypeComponents& target) const override;
+    void moveTo(AnyTypeComponents& target) override;
+
+    void removing(Entity entity) override
+    {
+        auto index = std::get<0>(_pools)->find(entity);
+        if (index == SparseIndex::npos || index >= _size) {
+            return;
+        }
+        --_size;
+        std::apply([this, entity] (auto*... pools) {
+            (pools->swapEntries(pools->find(entity), _size), ...);
+        }, _pools);
+    }
+
+private:
+    void build()
+    {
+        auto& first = *std::get<0>(_pools);
+        for (size_t index = 0; index < first.size(); index++) {
+            // Entries moved here by added() have already been visited.
+            added(first.entities()[index]);
+        }
+        std::apply([this] (auto*... pools) {
+            (pools->setGroup(this), ...);
+        }, _pools);
+    }
+
+    std::tuple<OneTypeComponents<Owned>*...> _pools;
+    size_t _size = 0;
+};
+
+/**
+ * Pool of a component type defined at run time: one byte array of values
+ * with the size and alignment of the info, in the order of the entities,
+ * handled through the functions of the info. Such pools keep no change
+ * ticks and have no hooks.
+ */
+class RawComponents final : public AbstractComponents {
+public:
+    RawComponents(
+            const ComponentInfo& info,
+            std::pmr::memory_resource* resource)
+        : _info(info)
+        , _resource(resource)
+        , _entities(resource)
+        , _entityIndex(resource)
+    { }
+
+    RawComponents(const RawComponents&) = delete;
+    RawComponents& operator=(const RawComponents&) = delete;
+
+    ~RawComponents() override
+    {
+        for (size_t index = 0; index < size(); index++) {
+            destroy(at(index));
+        }
+        if (_data) {
+            _resource->deallocate(
+                _data, _capacity * _info.size, _info.alignment);
+        }
+    }
+
+    size_t size() const
+    {
+        return _entities.size();
+    }
+
+    size_t find(Entity entity) const
+    {
+        auto index = _entityIndex.find(entity);
+        if (index == SparseIndex::npos || _entities[index] != entity) {
+            return SparseIndex::npos;
+        }
+        return index;
+    }
+
+    bool contains(Entity entity) const override
+    {
+        return find(entity) != SparseIndex::npos;
+    }
+
+    std::span<const Entity> entities() const override
+    {
+        return _entities;
+    }
+
+    void markChanged(Entity) override {}
+
+    /**
+     * An entity that already has the component gets the new value in place
+     * of the old one.
+     */
+    void* addRaw(Entity entity, void* value) override
+    {
+        auto address = slot(entity);
+        if (value) {
+            move(address, value);
+        } else {
+            construct(address);
+        }
+        return address;
+    }
+
+    const void* findRaw(Entity entity) const override
+    {
+        auto index = find(entity);
+        return index == SparseIndex::npos ? nullptr : at(index);
+    }
+
+    const void* rawData() const override
+    {
+        return _data;
+    }
+
+    void killEntity(Entity entity) override
+    {
+        auto index = find(entity);
+        if (index == SparseIndex::npos) {
+            return;
+        }
+        auto last = size() - 1;
+        destroy(at(index));
+        if (index != last) {
+            move(at(index), at(last));
+            destroy(at(last));
+            _entities[index] = _entities[last];
+            _entityIndex.set(_entities[index], index);
+        }
+        _entityIndex.erase(entity);
+        _entities.pop_back();
+    }
+
+    void copyEntity(Entity source, std::span<const Entity> targets) override
+    {
+        auto index = find(source);
+        if (index == SparseIndex::npos) {
+            return;
+        }
+        // Reserve first, so that the source stays in place. The source is
+        // skipped: copying would destroy the value it copies from.
+        reserve(size() + targets.size());
+        for (auto target : targets) {
+            if (target != source) {
+                copy(slot(target), at(index));
+            }
+        }
+    }
+
+    PoolStatistics statistics() const override
+    {
+        PoolStatistics statistics;
+        statistics.component = _info.id;
+        statistics.size = size();
+        statistics.capacity = _capacity;
+        statistics.componentBytes = _capacity * _info.size;
+        statistics.indexBytes = _entityIndex.memory() +
+            _entities.capacity() * sizeof(Entity);
+
+        auto live = size() * (_info.size + sizeof(Entity) + sizeof(uint32_t));
+        auto total = statistics.totalBytes();
+        statistics.fragmentation = total == 0 ?
+            0 : 1 - static_cast<double>(std::min(live, total)) /
+                static_cast<double>(total);
+        return statistics;
+    }
+
+    // Values are not reordered; compaction only releases unused memory,
+    // one array per call as for OneTypeComponents::compact().
+    bool compact(PoolCompaction& state, size_t& budget) override
+    {
+        if (!_entityIndex.releasePages(state.page, budget) || budget == 0) {
+            return false;
+        }
+        budget = 0;
+        switch (state.array++) {
+            case 0:
+                if (_capacity > size()) {
+                    reallocate(size());
+                }
+                return false;
+            case 1:
+                _entities.shrink_to_fit();
+                return false;
+            default:
+                _entityIndex.trimPages();
+                return true;
+        }
+    }
+
+    void moveHooks(AnyTypeComponents&) override {}
+
+    void cloneInto(AnyTypeComponents& target) const override;
+
+    void moveEntities(
+        std::span<const Entity> sources,
+        AnyTypeComponents& target,
+        std::span<const Entity> destinations) override;
+
+private:
+    std::byte* at(size_t index) const
+    {
+        return _data + index * _info.size;
+    }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity > _capacity) {
+            reallocate(std::max({capacity, 2 * _capacity, size_t{8}}));
+        }
+    }
+
+    // Move the values to a new array with the given capacity, which must
+    // hold them all.
+    void reallocate(size_t capacity)
+    {
+        std::byte* data = nullptr;
+        if (capacity > 0) {
+            data = static_cast<std::byte*>(_resource->allocate(
+                capacity * _info.size, _info.alignment));
+        }
+        for (size_t index = 0; index < size(); index++) {
+            move(data + index * _info.size, at(index));
+            destroy(at(index));
+        }
+        if (_data) {
+            _resource->deallocate(
+                _data, _capacity * _info.size, _info.alignment);
+        }
+        _data = data;
+        _capacity = capacity;
+    }
+
+    // The address to construct the value of the entity at: that of its old
+    // value, destroyed, or of a new entry.
+    std::byte* slot(Entity entity)
+    {
+        if (auto index = find(entity); index != SparseIndex::npos) {
+            destroy(at(index));
+            return at(index);
+        }
+        reserve(size() + 1);
+        _entityIndex.set(entity, size());
+        _entities.push_back(entity);
+        return at(size() - 1);
+    }
+
+    void construct(void* address) const
+    {
+        if (_info.construct) {
+            _info.construct(address);
+        } else {
+            std::memset(address, 0, _info.size);
+        }
+    }
+
+    void copy(void* target, const void* source) const
+    {
+        if (_info.copy) {
+            _info.copy(target, source);
+        } else {
+            std::memcpy(target, source, _info.size);
+        }
+    }
+
+    void move(void* target, void* source) const
+    {
+        if (_info.move) {
+            _info.move(target, source);
+        } else {
+            std::memcpy(target, source, _info.size);
+        }
+    }
+
+    void destroy(void* address) const
+    {
+        if (_info.destroy) {
+            _info.destroy(address);
+        }
+    }
+
+    const ComponentInfo& _info;
+    std::pmr::memory_resource* _resource;
+    std::byte* _data = nullptr;
+    size_t _capacity = 0;
+    std::pmr::vector<Entity> _entities;
+    SparseIndex _entityIndex;
+};
+
+/**
+ * Pools of all component types, in a flat array indexed by component ID.
+ */
+class AnyTypeComponents {
+public:
+    explicit AnyTypeComponents(
+            std::pmr::memory_resource* resource =
+                std::pmr::get_default_resource())
+        : _resource(resource)
+    { }
+
+    std::pmr::memory_resource* resource() const
+    {
+        return _resource;
+    }
+
+    /**
+     * Compact the pools one after another, from the one with the given ID.
+     * Returns true once all of them are done.
+     */
+    bool compact(ComponentId& pool, PoolCompaction& state, size_t& budget)
+    {
+        for (; pool < _components.size(); pool++) {
+            auto& components = _components[pool];
+            if (components && !components->compact(state, budget)) {
+                return false;
+            }
+            state = {};
+        }
+        return true;
+    }
+
+    void statistics(std::vector<PoolStatistics>& statistics) const
+    {
+        for (const auto& components : _components) {
+            if (components) {
+                statistics.push_back(components->statistics());
+            }
+        }
+    }
+
+    template <class Component>
+    bool has() const
+    {
+        return find<Component>() != nullptr;
+    }
+
+    template <class Component>
+    const OneTypeComponents<Component>* find() const
+    {
+        auto id = componentId<Component>();
+        if (id >= _components.size()) {
+            return nullptr;
+        }
+        return static_cast<const OneTypeComponents<Component>*>(
+            _components[id].get());
+    }
+
+    template <class Component>
+    OneTypeComponents<Component>* find()
+    {
+        auto id = componentId<Component>();
+        if (id >= _components.size()) {
+            return nullptr;
+        }
+        return static_cast<OneTypeComponents<Component>*>(
+            _components[id].get());
+    }
+
+    template <class Component>
+    const OneTypeComponents<Component>& at() const
+    {
+        auto pool = find<Component>();
+        if (!pool) {
+            throw std::out_of_range{
+                "ge::thing::internals::AnyTypeComponents::at"};
+        }
+        return *pool;
+    }
+
+    template <class Component>
+    OneTypeComponents<Component>& at()
+    {
+        return const_cast<OneTypeComponents<Component>&>(
+            std::as_const(*this).at<Component>());
+    }
+
+    const AbstractComponents* find(ComponentId id) const
+    {
+        return id < _components.size() ? _components[id].get() : nullptr;
+    }
+
+    AbstractComponents* find(ComponentId id)
+    {
+        return id < _components.size() ? _components[id].get() : nullptr;
+    }
+
+    /**
+     * The pool of the component type, created if needed: a typed pool for
+     * C++ types, and a raw one for types defined at run time.
+     */
+    AbstractComponents& create(const ComponentInfo& info)
+    {
+        if (info.id >= _components.size()) {
+            _components.resize(info.id + 1);
+        }
+        auto& components = _components[info.id];
+        if (!components) {
+            if (info.createPool) {
+                components = info.createPool(_clock, _resource);
+            } else {
+                components = std::make_unique<RawComponents>(
+                    info, _resource);
+            }
+        }
+        return *components;
+    }
+
+    template <class Component>
+    OneTypeComponents<Component>& create()
+    {
+        auto id = componentId<Component>();
+        if (id >= _components.size()) {
+            _components.resize(id + 1);
+        }
+        auto& components = _components[id];
+        if (!components) {
+            components = std::make_unique<OneTypeComponents<Component>>(
+                _clock, _resource);
+        }
+        return static_cast<OneTypeComponents<Component>&>(*components);
+    }
+
+    /**
+     * The owning group of the components, created on first use. Throws
+     * std::logic_error if one of the pools is already owned by a group of
+     * other components.
+     */
+    template <class... Owned>
+    OwningGroup<Owned...>& group()
+    {
+        auto pools = std::tuple<OneTypeComponents<Owned>&...>{
+            create<Owned>()...};
+        auto existing = std::get<0>(pools).group();
+        if (auto group = dynamic_cast<OwningGroup<Owned...>*>(existing)) {
+            return *group;
+        }
+        std::apply([] (auto&... pools) {
+            if ((... || pools.group())) {
+                throw std::logic_error{
+                    "ge::thing::internals::AnyTypeComponents::group: "
+                    "component is owned by another group"};
+            }
+        }, pools);
+
+        auto group = std::make_unique<OwningGroup<Owned...>>(
+            create<Owned>()...);
+        auto& ref = *group;
+        _groups.push_back(std::move(group));
+        return ref;
+    }
+
+    Tick tick() const
+    {
+        return _clock->tick;
+    }
+
+    Tick advanceTick()
+    {
+        return _clock->tick++;
+    }
+
+    void setTick(Tick tick)
+    {
+        _clock->tick = tick;
+    }
+
+    void killEntity(Entity entity)
+    {
+        for (auto& components : _components) {
+            if (components) {
+                components->killEntity(entity);
+            }
+        }
+    }
+
+    void copyEntity(Entity source, std::span<const Entity> targets)
+    {
+        for (auto& components : _components) {
+            if (components) {
+                components->copyEntity(source, targets);
+            }
+        }
+    }
+
+    /**
+     * Copy the pools and groups into the target, which must be empty. The
+     * hooks are not copied.
+     */
+    void cloneInto(AnyTypeComponents& target) const
+    {
+        target.setTick(tick());
+        for (const auto& components : _components) {
+            if (components) {
+                components->cloneInto(target);
+            }
+        }
+        for (const auto& group : _groups) {
+            group->cloneInto(target);
+        }
+    }
+
+    /**
+     * Move the components of each source entity to the destination entity
+     * at the same position, visiting each pool once.
+     */
+    void moveEntities(
+        std::span<const Entity> sources,
+        AnyTypeComponents& target,
+        std::span<const Entity> destinations)
+    {
+        for (auto& components : _components) {
+            if (components) {
+                components->moveEntities(sources, target, destinations);
+            }
+        }
+    }
+
+    /**
+     * Move the hooks of the pools to the pools of the target, creating
+     * those if needed.
+     */
+    void moveHooks(AnyTypeComponents& target)
+    {
+        for (auto& components : _components) {
+            if (components) {
+                components->moveHooks(target);
+            }
+        }
+    }
+
+    /**
+     * Move the groups to the pools of the target, which must have no
+     * groups, and rebuild them there. The group objects stay the same, so
+     * Group handles stay valid. Pools of owned components are created in
+     * the target if needed; nothing is moved if that throws.
+     */
+    void moveGroups(AnyTypeComponents& target)
+    {
+        for (const auto& group : _groups) {
+            group->createPools(target);
+        }
+        target._groups.reserve(_groups.size());
+        for (auto& group : _groups) {
+            group->moveTo(target);
+            target._groups.push_back(std::move(group));
+        }
+        _groups.clear();
+    }
+
+    void killEntities(std::span<const Entity> entities)
+    {
+        for (auto& components : _components) {
+            if (components) {
+                for (auto entity : entities) {
+                    components->killEntity(entity);
+                }
+            }
+        }
+    }
+
+private:
+    std::pmr::memory_resource* _resource;
+    std::shared_ptr<Clock> _clock = std::make_shared<Clock>();
+    std::vector<std::unique_ptr<AbstractComponents>> _components;
+    std::vector<std::unique_ptr<AbstractGroup>> _groups;
+};
+
+template <class Component>
+void OneTypeComponents<Component>::moveHooks(AnyTypeComponents& target)
+{
+    if (_hooks) {
+        target.create<Component>()._hooks = std::move(_hooks);
+    }
+}
+
+template <class Component>
+void OneTypeComponents<Component>::cloneInto(AnyTypeComponents& target) const
+{
+    if constexpr (std::copy_constructible<Component>) {
+        auto& pool = target.create<Component>();
+        pool._components.assign(_components);
+        pool._entities.assign(_entities.begin(), _entities.end());
+        pool._entityIndex = _entityIndex;
+        pool._addedTicks.assign(_addedTicks.begin(), _addedTicks.end());
+        pool._changedTicks.assign(
+            _changedTicks.begin(), _changedTicks.end());
+        pool._chunkTicks.assign(_chunkTicks.begin(), _chunkTicks.end());
+    } else {
+        throw std::logic_error{
+            "ge::thing::internals::OneTypeComponents::cloneInto: "
+            "component is not copyable"};
+    }
+}
+
+template <class Component>
+void OneTypeComponents<Component>::moveEntities(
+    std::span<const Entity> sources,
+    AnyTypeComponents& target,
+    std::span<const Entity> destinations)
+{
+    OneTypeComponents* pool = nullptr;
+    for (size_t i = 0; i < sources.size(); i++) {
+        auto index = find(sources[i]);
+        if (index == SparseIndex::npos) {
+            continue;
+        }
+        if (!pool) {
+            pool = &target.create<Component>();
+            pool->grow(std::min(size(), sources.size()));
+        }
+        if (_hooks) {
+            notify(ComponentEvent::Removed, sources[i], _components[index]);
+        }
+        if constexpr (std::is_reference_v<Reference>) {
+            Component component = std::move(_components[index]);
+            erase(sources[i], index);
+            pool->add(destinations[i], std::move(component));
+        } else {
+            Component component = _components[index];
+            erase(sources[i], index);
+            pool->add(destinations[i], std::move(component));
+        }
+    }
+}
+
+template <class Component>
+std::unique_ptr<AbstractComponents> createPool(
+    std::shared_ptr<const Clock> clock,
+    std::pmr::memory_resource* resource)
+{
+    return std::make_unique<OneTypeComponents<Component>>(
+        std::move(clock), resource);
+}
+
+inline void RawComponents::cloneInto(AnyTypeComponents& target) const
+{
+    auto& pool = static_cast<RawComponents&>(target.create(_info));
+    pool.reserve(size());
+    for (size_t index = 0; index < size(); index++) {
+        copy(pool.at(index), at(index));
+    }
+    pool._entities.assign(_entities.begin(), _entities.end());
+    pool._entityIndex = _entityIndex;
+}
+
+inline void RawComponents::moveEntities(
+    std::span<const Entity> sources,
+    AnyTypeComponents& target,
+    std::span<const Entity> destinations)
+{
+    for (size_t i = 0; i < sources.size(); i++) {
+        auto index = find(sources[i]);
+        if (index != SparseIndex::npos) {
+            target.create(_info).addRaw(destinations[i], at(index));
+            // The moved-from value is destroyed with the entry.
+            killEntity(sources[i]);
+        }
+    }
+}
+
+template <class... Owned>
+void OwningGroup<Owned...>::cloneInto(AnyTypeComponents& target) const
+{
+    // The pools are copied in group order, so the group finds its entries
+    // in place.
+    target.group<Owned...>();
+}
+
+template <class... Owned>
+void OwningGroup<Owned...>::createPools(AnyTypeComponents& target) const
+{
+    (target.create<Owned>(), ...);
+}
+
+template <class... Owned>
+void OwningGroup<Owned...>::moveTo(AnyTypeComponents& target)
+{
+    _pools = {&target.create<Owned>()...};
+    _size = 0;
+    build();
+}
+
+/**
+ * What pools return for access to a possibly const component.
+ */
+template <class Component>
+struct ReferenceTraits {
+    using Type = typename StorageFor<Component>::Type::Reference;
+};
+
+template <class Component>
+struct ReferenceTraits<const Component> {
+    using Type = typename StorageFor<Component>::Type::ConstReference;
+};
+
+template <class Component>
+using ReferenceFor = typename ReferenceTraits<Component>::Type;
+
+template <class Component>
+using PoolFor = std::conditional_t<
+    std::is_const_v<Component>,
+    const OneTypeComponents<std::remove_const_t<Component>>,
+    OneTypeComponents<Component>>;
+
+} // namespace ge::thing::internals
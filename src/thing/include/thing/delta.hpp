@@ -0,0 +1,262 @@
+#pragma once
+
+#include <thing/blob.hpp>
+#include <thing/component_id.hpp>
+#include <thing/entity.hpp>
+#include <thing/entity_manager.hpp>
+#include <thing/journal.hpp>
+#include <thing/tick.hpp>
+#include <thing/view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+namespace internals {
+
+// "THDL" in little-endian byte order.
+inline constexpr uint32_t DeltaMagic = 0x4c444854;
+inline constexpr uint32_t DeltaVersion = 2;
+inline constexpr uint32_t NoDeltaType = static_cast<uint32_t>(-1);
+
+/**
+ * Position of the component ID in the component list, or NoDeltaType.
+ */
+template <class... Components>
+uint32_t deltaType(ComponentId id)
+{
+    uint32_t index = 0;
+    uint32_t type = NoDeltaType;
+    ((componentId<Components>() == id ? (void)(type = index) : (void)0,
+        ++index), ...);
+    return type;
+}
+
+[[noreturn]] inline void badDelta(const char* reason)
+{
+    throw std::runtime_error{
+        std::string{"ge::thing::applyDelta: "} + reason};
+}
+
+} // namespace internals
+
+/**
+ * Encodes what changed in an entity manager between two calls of encode():
+ * created and killed entities, removed components, compaction steps of the
+ * entity slots, and the values of the listed components that were added or
+ * changed. The result can be applied
+ * to another manager that was in the same state as this one when the
+ * encoder was created, e.g. one restored from a snapshot.
+ *
+ * Structural changes are taken from a journal that the manager keeps only
+ * while an encoder exists; changed values come from the change ticks of
+ * the pools, so the cost of encode() is proportional to the number of
+ * changes, not the number of entities. A manager can have one encoder at a
+ * time. The listed components must be trivially copyable, and the list
+ * identifies them in the delta, as with snapshots.
+ */
+template <class... Components>
+class DeltaEncoder {
+    static_assert(
+        (... && std::is_trivially_copyable_v<Components>),
+        "only trivially copyable components can be encoded");
+
+public:
+    explicit DeltaEncoder(EntityManager& manager)
+        : _manager(manager)
+    {
+        if (manager._journal.enabled()) {
+            throw std::logic_error{
+                "ge::thing::DeltaEncoder: manager already has an encoder"};
+        }
+        manager._journal.enable(true);
+        _since = manager.advanceTick();
+    }
+
+    DeltaEncoder(const DeltaEncoder&) = delete;
+    DeltaEncoder(DeltaEncoder&&) = delete;
+    DeltaEncoder& operator=(const DeltaEncoder&) = delete;
+    DeltaEncoder& operator=(DeltaEncoder&&) = delete;
+
+    ~DeltaEncoder()
+    {
+        _manager._journal.enable(false);
+    }
+
+    /**
+     * Replace the contents of the buffer with the changes since the
+     * previous call, and start collecting the next ones. Once the buffer
+     * and the journal have grown to the size of a typical delta, encoding
+     * does not allocate.
+     */
+    void encode(std::vector<std::byte>& delta)
+    {
+        delta.clear();
+        internals::BufferWriter writer{delta};
+        writer.write(internals::DeltaMagic);
+        writer.write(internals::DeltaVersion);
+        writer.write<uint32_t>(sizeof...(Components));
+        writer.write<uint64_t>(_manager._entityPool.slotCount());
+
+        auto countPosition = writer.position();
+        writer.write<uint64_t>(0);
+        uint64_t count = 0;
+        for (const auto& event : _manager._journal.events()) {
+            auto type = internals::NoDeltaType;
+            if (event.kind == internals::Journal::Kind::Removed) {
+                type = internals::deltaType<Components...>(event.component);
+                if (type == internals::NoDeltaType) {
+                    continue;
+                }
+            } else if (event.kind == internals::Journal::Kind::Relinked) {
+                // A step never goes through more slots than there are.
+                type = static_cast<uint32_t>(event.component);
+            }
+            writer.write(event.kind);
+            writer.write(event.entity);
+            writer.write(type);
+            ++count;
+        }
+        writer.patch(countPosition, count);
+        _manager._journal.clear();
+
+        auto since = std::exchange(_since, _manager.advanceTick());
+        (writeChanges<Components>(writer, since), ...);
+    }
+
+private:
+    template <class Component>
+    void writeChanges(internals::BufferWriter& writer, Tick since) const
+    {
+        writer.write<uint32_t>(sizeof(Component));
+        auto countPosition = writer.position();
+        writer.write<uint64_t>(0);
+        uint64_t count = 0;
+        for (auto [entity, component] :
+                _manager.view<Changed<const Component>>(since)) {
+            writer.write(entity);
+            writer.write<Component>(component);
+            ++count;
+        }
+        writer.patch(countPosition, count);
+    }
+
+    EntityManager& _manager;
+    Tick _since = 0;
+};
+
+namespace internals {
+
+template <class... Components>
+void removeDeltaComponent(
+    EntityManager& manager, uint32_t type, Entity entity)
+{
+    if (type >= sizeof...(Components)) {
+        badDelta("bad component type");
+    }
+    uint32_t index = 0;
+    ((index++ == type ? manager.remove<Components>(entity) : void()), ...);
+}
+
+template <class Component>
+void applyDeltaChanges(EntityManager& manager, BlobReader& reader)
+{
+    if (reader.read<uint32_t>() != sizeof(Component)) {
+        badDelta("component layout mismatch");
+    }
+    auto count = reader.readArraySize(sizeof(Entity) + sizeof(Component));
+    for (size_t i = 0; i < count; i++) {
+        auto entity = reader.read<Entity>();
+        auto component = reader.read<Component>();
+        if (manager.alive(entity)) {
+            manager.add<Component>(entity, std::move(component));
+        }
+    }
+}
+
+} // namespace internals
+
+/**
+ * Apply a delta made by DeltaEncoder<Components...> with the same component
+ * list. Throws std::runtime_error if the delta is malformed or was encoded
+ * with another list; the manager may be partially updated in that case.
+ */
+template <class... Components>
+void applyDelta(EntityManager& manager, std::span<const std::byte> delta)
+{
+    using Kind = internals::Journal::Kind;
+
+    internals::BlobReader reader{delta};
+    if (reader.read<uint32_t>() != internals::DeltaMagic) {
+        internals::badDelta("not a delta");
+    }
+    if (reader.read<uint32_t>() != internals::DeltaVersion) {
+        internals::badDelta("unsupported version");
+    }
+    if (reader.read<uint32_t>() != sizeof...(Components)) {
+        internals::badDelta("component count mismatch");
+    }
+    auto slotCount = reader.read<uint64_t>();
+
+    // Created slots are claimed without unlinking each of them from the
+    // free list; if any was not at its head, the list is relinked in one
+    // pass over all slots at the end. Compaction steps of the source are
+    // replayed, so that its free list keeps matching the one of the
+    // target, and that pass stays rare.
+    auto count = reader.readArraySize(
+        sizeof(Kind) + sizeof(Entity) + sizeof(uint32_t));
+    bool linked = true;
+    try {
+        for (size_t i = 0; i < count; i++) {
+            auto kind = reader.read<Kind>();
+            auto entity = reader.read<Entity>();
+            auto type = reader.read<uint32_t>();
+            switch (kind) {
+                case Kind::Created:
+                    if (manager.alive(entity)) {
+                        break;
+                    }
+                    try {
+                        linked =
+                            manager.claimEntity(entity, slotCount) && linked;
+                    } catch (const std::invalid_argument&) {
+                        internals::badDelta("bad created entity");
+                    }
+                    break;
+                case Kind::Killed:
+                    manager.killEntity(entity);
+                    break;
+                case Kind::Removed:
+                    internals::removeDeltaComponent<Components...>(
+                        manager, type, entity);
+                    break;
+                case Kind::Relinked: {
+                    size_t budget = type;
+                    manager._entityPool.compact(budget);
+                    break;
+                }
+                default:
+                    internals::badDelta("bad event");
+            }
+        }
+    } catch (...) {
+        if (!linked) {
+            manager._entityPool.relinkFree();
+        }
+        throw;
+    }
+    if (!linked) {
+        manager._entityPool.relinkFree();
+    }
+
+    (internals::applyDeltaChanges<Components>(manager, reader), ...);
+}
+
+} // namespace ge::thing
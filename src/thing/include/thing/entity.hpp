@@ -0,0 +1,470 @@
+#pragma once
+
+#include <thing/blob.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+/**
+ * Entity handle: a slot index in the low 32 bits and the generation of the
+ * slot in the high 32 bits. Once an entity is killed, the generation of its
+ * slot is bumped, so old handles to it never compare equal to new ones.
+ */
+class Entity {
+public:
+    using ValueType = uint64_t;
+    using IndexType = uint32_t;
+    using GenerationType = uint32_t;
+
+    explicit Entity(ValueType id) : _id(id) {}
+
+    Entity(IndexType index, GenerationType generation)
+        : _id(static_cast<ValueType>(generation) << 32 | index)
+    { }
+
+    operator ValueType() const { return _id; }
+
+    IndexType index() const
+    {
+        return static_cast<IndexType>(_id);
+    }
+
+    GenerationType generation() const
+    {
+        return static_cast<GenerationType>(_id >> 32);
+    }
+
+    friend auto operator<=>(Entity lhs, Entity rhs)
+    {
+        return lhs._id <=> rhs._id;
+    }
+
+private:
+    ValueType _id;
+};
+
+namespace internals {
+
+/**
+ * Dense array of entity slots. A live slot holds the entity itself. A dead
+ * slot holds the index of the next free slot, and the generation its next
+ * entity will get.
+ */
+class EntityPool {
+public:
+    explicit EntityPool(
+            std::pmr::memory_resource* resource =
+                std::pmr::get_default_resource())
+        : _slots(resource)
+    { }
+
+    /**
+     * The source is left empty. Handles reserved from it but not flushed
+     * yet move along with its slots.
+     */
+    EntityPool(EntityPool&& other) noexcept
+        : _slots(std::move(other._slots))
+        , _freeHead(std::exchange(other._freeHead, NoSlot))
+        , _freeTail(std::exchange(other._freeTail, NoSlot))
+        , _relinked(std::exchange(other._relinked, NotRelinking))
+        , _reserved(other._reserved.exchange(0))
+    {
+        other._slots.clear();
+    }
+
+    /**
+     * Like the move constructor. The slots are taken over when both pools
+     * use the same memory resource; otherwise they are copied, and a
+     * failure to allocate terminates.
+     */
+    EntityPool& operator=(EntityPool&& other) noexcept
+    {
+        if (this != &other) {
+            _slots = std::move(other._slots);
+            other._slots.clear();
+            _freeHead = std::exchange(other._freeHead, NoSlot);
+            _freeTail = std::exchange(other._freeTail, NoSlot);
+            _relinked = std::exchange(other._relinked, NotRelinking);
+            _reserved = other._reserved.exchange(0);
+        }
+        return *this;
+    }
+
+    Entity createEntity()
+    {
+        flushReserved();
+        if (_freeHead == NoSlot) {
+            auto index = static_cast<Entity::IndexType>(_slots.size());
+            _slots.push_back(Entity{index, 0});
+            return _slots.back();
+        }
+
+        auto index = _freeHead;
+        auto& slot = _slots[index];
+        _freeHead = slot.index();
+        slot = Entity{index, slot.generation()};
+        return slot;
+    }
+
+    /**
+     * Create as many entities as there are elements in the span. Recycled
+     * slots are used first, then the slot array grows once for the rest,
+     * at least doubling.
+     */
+    void createEntities(std::span<Entity> entities)
+    {
+        flushReserved();
+
+        size_t created = 0;
+        while (created < entities.size() && _freeHead != NoSlot) {
+            entities[created++] = createEntity();
+        }
+
+        auto size = _slots.size() + entities.size() - created;
+        if (size > _slots.capacity()) {
+            _slots.reserve(std::max(size, 2 * _slots.capacity()));
+        }
+        while (created < entities.size()) {
+            auto index = static_cast<Entity::IndexType>(_slots.size());
+            _slots.push_back(Entity{index, 0});
+            entities[created++] = _slots.back();
+        }
+    }
+
+    /**
+     * Make the given handle alive, e.g. to mirror the entities of another
+     * pool. Slots up to its index are added as dead ones if needed. Throws
+     * std::invalid_argument if the slot is in use, if the handle is older
+     * than the slot, which would revive stale handles, or if the index is
+     * the largest one, which marks the end of the free list.
+     */
+    Entity createEntity(Entity entity)
+    {
+        auto index = entity.index();
+        auto next = freeSlot(entity).index();
+
+        // Unlink the slot from the free list, unless a relink has yet to
+        // reach it. New slots are at its head.
+        if (index < _relinked) {
+            unlink(index, next);
+        }
+        _slots[index] = entity;
+        return entity;
+    }
+
+    /**
+     * Make the given handle alive like createEntity(Entity), without
+     * walking the free list: unless the slot is at its head, as it is when
+     * the pool mirrors another one, the list is dropped and false is
+     * returned. Then relinkFree() must be called before entities are
+     * created again; killing entities meanwhile is fine. The index must be
+     * below slotLimit, the slot count of the mirrored pool, or
+     * std::invalid_argument is thrown, as for the errors of
+     * createEntity(Entity).
+     */
+    bool claimEntity(Entity entity, size_t slotLimit)
+    {
+        flushReserved();
+        auto index = entity.index();
+        if (index >= slotLimit) {
+            throw std::invalid_argument{
+                "ge::thing::internals::EntityPool::claimEntity: "
+                "index past the slots"};
+        }
+        auto next = freeSlot(entity).index();
+        // A slot that a relink has yet to reach is on no list.
+        bool linked = index >= _relinked || _freeHead == index;
+        if (index < _relinked) {
+            _freeHead = linked ? next : NoSlot;
+        }
+        _slots[index] = entity;
+        return linked;
+    }
+
+    void killEntity(Entity entity)
+    {
+        if (!alive(entity)) {
+            return;
+        }
+
+        release(entity.index(), entity.generation() + 1);
+    }
+
+    bool alive(Entity entity) const
+    {
+        return entity.index() < _slots.size() &&
+            _slots[entity.index()] == entity;
+    }
+
+    /**
+     * Reserve a handle for an entity that becomes alive at the next
+     * flushReserved(). Reserved handles always get fresh slots past the end
+     * of the slot array. Safe to call concurrently, as long as nothing else
+     * modifies the pool at the same time.
+     */
+    Entity reserveEntity()
+    {
+        auto index = _slots.size() + _reserved++;
+        return Entity{static_cast<Entity::IndexType>(index), 0};
+    }
+
+    void flushReserved()
+    {
+        for (auto count = _reserved.exchange(0); count > 0; count--) {
+            auto index = static_cast<Entity::IndexType>(_slots.size());
+            _slots.push_back(Entity{index, 0});
+        }
+    }
+
+    /**
+     * Number of slots, live or dead. All entity indices are below this.
+     */
+    size_t slotCount() const
+    {
+        return _slots.size();
+    }
+
+    /**
+     * Relink the free list in the order of slot indices, so that new
+     * entities take the lowest free slots first, then release unused
+     * capacity. Like OneTypeComponents::compact(), does at most budget
+     * units of work, one per slot, and returns true once finished; the
+     * shrink, which may move every slot, comes with the last range. Until
+     * then, dead slots that the relink has not reached are on no list, and
+     * new entities get new slots once the relinked ones run out. Dead slots
+     * cannot be dropped: they keep the generations that tell old handles
+     * apart from new ones.
+     */
+    bool compact(size_t& budget)
+    {
+        flushReserved();
+        if (_relinked == NotRelinking) {
+            _relinked = 0;
+            _freeHead = NoSlot;
+        }
+        for (; budget > 0 && _relinked < _slots.size(); _relinked++) {
+            --budget;
+            auto index = static_cast<Entity::IndexType>(_relinked);
+            auto& slot = _slots[index];
+            if (slot.index() == index) {
+                continue;
+            }
+            slot = Entity{NoSlot, slot.generation()};
+            if (_freeHead == NoSlot) {
+                _freeHead = index;
+            } else {
+                _slots[_freeTail] =
+                    Entity{index, _slots[_freeTail].generation()};
+            }
+            _freeTail = index;
+        }
+        if (_relinked < _slots.size()) {
+            return false;
+        }
+        _relinked = NotRelinking;
+        _slots.shrink_to_fit();
+        return true;
+    }
+
+    /**
+     * Link all dead slots into the free list, in the order of their
+     * indices, in one pass over the slots. Ends a relink by compact().
+     */
+    void relinkFree()
+    {
+        _relinked = NotRelinking;
+        _freeHead = NoSlot;
+        for (auto index = _slots.size(); index-- > 0; ) {
+            auto& slot = _slots[index];
+            if (slot.index() != index) {
+                slot = Entity{_freeHead, slot.generation()};
+                _freeHead = static_cast<Entity::IndexType>(index);
+            }
+        }
+    }
+
+    // Counts the live slots, in linear time.
+    size_t liveCount() const
+    {
+        size_t count = 0;
+        for (size_t index = 0; index < _slots.size(); index++) {
+            count += _slots[index].index() == index;
+        }
+        return count;
+    }
+
+    size_t memory() const
+    {
+        return _slots.capacity() * sizeof(Entity);
+    }
+
+    /**
+     * Handles that are reserved but not yet flushed are not saved. Halfway
+     * through a relink by compact(), the free list is saved as a whole
+     * relink would leave it.
+     */
+    void save(BlobWriter& writer) const
+    {
+        if (_relinked != NotRelinking) {
+            EntityPool relinked{_slots.get_allocator().resource()};
+            relinked.assign(*this);
+            relinked.relinkFree();
+            relinked.save(writer);
+            return;
+        }
+        writer.writeArray<Entity>(_slots);
+        writer.write(_freeHead);
+    }
+
+    /**
+     * Throws std::runtime_error unless the free list links exactly the
+     * dead slots, which takes a pass over the slots and a walk of the
+     * list: a bad link would hand out live slots, or read past the array.
+     */
+    void load(BlobReader& reader)
+    {
+        std::pmr::vector<Entity> slots{_slots.get_allocator()};
+        reader.readArray(slots);
+        auto freeHead = reader.read<Entity::IndexType>();
+
+        size_t dead = 0;
+        for (size_t index = 0; index < slots.size(); index++) {
+            dead += slots[index].index() != index;
+        }
+        size_t linked = 0;
+        for (auto index = freeHead; index != NoSlot; ) {
+            // A list longer than the number of dead slots has a loop.
+            if (index >= slots.size() || slots[index].index() == index ||
+                    ++linked > dead) {
+                badFreeList();
+            }
+            index = slots[index].index();
+        }
+        if (linked != dead) {
+            badFreeList();
+        }
+        _slots = std::move(slots);
+        _freeHead = freeHead;
+        _relinked = NotRelinking;
+        _reserved = 0;
+    }
+
+    /**
+     * Copy the slots of the other pool. As with save(), its reserved
+     * handles are not copied.
+     */
+    void assign(const EntityPool& other)
+    {
+        _slots.assign(other._slots.begin(), other._slots.end());
+        _freeHead = other._freeHead;
+        _freeTail = other._freeTail;
+        _relinked = other._relinked;
+        _reserved = 0;
+    }
+
+    void swap(EntityPool& other) noexcept
+    {
+        std::swap(_slots, other._slots);
+        std::swap(_freeHead, other._freeHead);
+        std::swap(_freeTail, other._freeTail);
+        std::swap(_relinked, other._relinked);
+        _reserved = other._reserved.exchange(_reserved);
+    }
+
+private:
+    static constexpr Entity::IndexType NoSlot =
+        std::numeric_limits<Entity::IndexType>::max();
+    static constexpr size_t NotRelinking = std::numeric_limits<size_t>::max();
+
+    [[noreturn]] static void badFreeList()
+    {
+        throw std::runtime_error{
+            "ge::thing::internals::EntityPool::load: bad free list"};
+    }
+
+    // The dead slot of the handle, with slots up to its index added as
+    // dead ones at the head of the free list if needed.
+    Entity freeSlot(Entity entity)
+    {
+        flushReserved();
+        auto index = entity.index();
+        if (index == NoSlot) {
+            throw std::invalid_argument{
+                "ge::thing::internals::EntityPool::createEntity: "
+                "index out of range"};
+        }
+        while (_slots.size() <= index) {
+            auto slot = static_cast<Entity::IndexType>(_slots.size());
+            _slots.push_back(Entity{NoSlot, 0});
+            release(slot, 0);
+        }
+        if (_slots[index].index() == index) {
+            throw std::invalid_argument{
+                "ge::thing::internals::EntityPool::createEntity: "
+                "slot in use"};
+        }
+        // Dead slots keep the generation their next handle gets.
+        if (entity.generation() < _slots[index].generation()) {
+            throw std::invalid_argument{
+                "ge::thing::internals::EntityPool::createEntity: "
+                "stale handle"};
+        }
+        return _slots[index];
+    }
+
+    // Take a dead slot off the free list, walking the list up to it.
+    void unlink(Entity::IndexType index, Entity::IndexType next)
+    {
+        if (_freeHead == index) {
+            _freeHead = next;
+            return;
+        }
+        auto previous = _freeHead;
+        while (_slots[previous].index() != index) {
+            previous = _slots[previous].index();
+        }
+        _slots[previous] = Entity{next, _slots[previous].generation()};
+        if (_freeTail == index) {
+            _freeTail = previous;
+        }
+    }
+
+    // Mark the slot dead, and push it to the head of the free list unless
+    // a relink has yet to reach it.
+    void release(
+        Entity::IndexType index, Entity::GenerationType generation)
+    {
+        if (index >= _relinked) {
+            _slots[index] = Entity{NoSlot, generation};
+            return;
+        }
+        if (_freeHead == NoSlot) {
+            _freeTail = index;
+        }
+        _slots[index] = Entity{_freeHead, generation};
+        _freeHead = index;
+    }
+
+    std::pmr::vector<Entity> _slots;
+    Entity::IndexType _freeHead = NoSlot;
+    // While compact() relinks the free list, the slots below _relinked are
+    // done, and the list ends with their dead slots, up to _freeTail.
+    Entity::IndexType _freeTail = NoSlot;
+    size_t _relinked = NotRelinking;
+    std::atomic<size_t> _reserved = 0;
+};
+
+} // namespace internals
+
+} // namespace ge::thing
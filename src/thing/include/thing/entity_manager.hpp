@@ -0,0 +1,1006 @@
+#pragma once
+
+#include <thing/access.hpp>
+#include <thing/blob.hpp>
+#include <thing/components.hpp>
+#include <thing/entity.hpp>
+#include <thing/group.hpp>
+#include <thing/hierarchy.hpp>
+#include <thing/hooks.hpp>
+#include <thing/journal.hpp>
+#include <thing/registry.hpp>
+#include <thing/statistics.hpp>
+#include <thing/thread_pool.hpp>
+#include <thing/tick.hpp>
+#include <thing/view.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+namespace internals {
+
+template <class Component>
+class Commands;
+
+} // namespace internals
+
+template <class... Components>
+class DeltaEncoder;
+
+class EntityManager {
+public:
+    EntityManager()
+        : EntityManager(std::pmr::get_default_resource())
+    { }
+
+    /**
+     * The entity slots and the component and index arrays of the pools are
+     * allocated from the memory resource, e.g. a
+     * std::pmr::monotonic_buffer_resource for a world whose bulk is
+     * released at once. The pool objects, groups, hooks, hierarchy and
+     * journal use the global heap. The manager must be destroyed before
+     * the resource.
+     */
+    explicit EntityManager(std::pmr::memory_resource* resource)
+        : _entityPool(resource)
+        , _components(resource)
+    { }
+
+    /**
+     * Moving a manager keeps its pools in place, so pointers to components
+     * and groups stay valid. Access tokens, queries and collectors refer
+     * to the manager itself and must not be in use meanwhile. The source
+     * may only be assigned to or destroyed afterwards.
+     */
+    EntityManager(EntityManager&& other) noexcept
+        : _entityPool(std::move(other._entityPool))
+        , _components(std::move(other._components))
+        , _journal(std::move(other._journal))
+        , _hierarchy(std::move(other._hierarchy))
+        , _compactPool(std::exchange(other._compactPool, 0))
+        , _compaction(std::exchange(other._compaction, {}))
+    { }
+
+    EntityManager& operator=(EntityManager&& other) noexcept
+    {
+        if (this != &other) {
+            _entityPool = std::move(other._entityPool);
+            _components = std::move(other._components);
+            _journal = std::move(other._journal);
+            _hierarchy = std::move(other._hierarchy);
+            _compactPool = std::exchange(other._compactPool, 0);
+            _compaction = std::exchange(other._compaction, {});
+        }
+        return *this;
+    }
+
+    /**
+     * A copy of the manager with the same entity handles, components,
+     * ticks, groups and hierarchy, e.g. to simulate ahead and discard the
+     * result. Pools are copied as whole arrays, as one block for trivially
+     * copyable components. Hooks are not copied, since they belong to the
+     * observers of this manager, and neither are reserved handles that are
+     * not flushed yet. The journal starts empty and disabled: changes
+     * pending for a DeltaEncoder of this manager are not carried over, and
+     * the copy can get an encoder of its own. Throws std::logic_error if a
+     * pool holds components that are not copyable.
+     */
+    EntityManager clone() const
+    {
+        return clone(_components.resource());
+    }
+
+    /**
+     * Clone with the arrays allocated from the memory resource, as by the
+     * constructor. The copy must be destroyed before the resource.
+     */
+    EntityManager clone(std::pmr::memory_resource* resource) const
+    {
+        return EntityManager{*this, resource};
+    }
+
+    template <class Component>
+    bool has(Entity entity) const
+    {
+        auto pool = _components.find<Component>();
+        return pool && pool->contains(entity);
+    }
+
+    /**
+     * Components with storage::Columns policy are returned as proxies.
+     */
+    template <class Component>
+    internals::ReferenceFor<const Component> component(Entity entity) const
+    {
+        return _components.at<Component>().component(entity);
+    }
+
+    /**
+     * Mutable access marks the component as changed at the current tick.
+     */
+    template <class Component>
+    internals::ReferenceFor<Component> component(Entity entity)
+    {
+        return _components.at<Component>().component(entity);
+    }
+
+    /**
+     * Copy the components of the entities into out, with lookups batched
+     * and prefetched ahead of the copies. See OneTypeComponents::gather().
+     */
+    template <class Component>
+    void gather(
+        std::span<const Entity> entities,
+        std::span<Component> out,
+        GatherOrder order = GatherOrder::Input) const
+    {
+        if (auto pool = _components.find<Component>()) {
+            pool->gather(entities, out, order);
+        } else if (!entities.empty()) {
+            throw std::out_of_range{"ge::thing::EntityManager::gather"};
+        } else if (!out.empty()) {
+            throw std::invalid_argument{
+                "ge::thing::EntityManager::gather: output size mismatch"};
+        }
+    }
+
+    /**
+     * Mark a component as changed at the current tick, e.g. after writing
+     * to it through the span returned by components().
+     */
+    template <class Component>
+    void markChanged(Entity entity)
+    {
+        _components.at<Component>().markChanged(entity);
+    }
+
+    template <class Component>
+    std::span<const Component> components() const
+    {
+        if (auto pool = _components.find<Component>()) {
+            return pool->components();
+        }
+        return {};
+    }
+
+    /**
+     * Writes through the returned span are not tracked as changes.
+     */
+    template <class Component>
+    std::span<Component> components()
+    {
+        if (auto pool = _components.find<Component>()) {
+            return pool->components();
+        }
+        return {};
+    }
+
+    /**
+     * One field of the components with storage::Columns policy, in the
+     * order of entities(), e.g. column<&Particle::x>(). Writes through the
+     * returned span are not tracked as changes.
+     */
+    template <auto Field>
+    auto column() const
+    {
+        using Component =
+            typename internals::MemberPointer<decltype(Field)>::Owner;
+        using Type = typename internals::MemberPointer<decltype(Field)>::Type;
+        if (auto pool = _components.find<Component>()) {
+            return pool->template column<Field>();
+        }
+        return std::span<const Type>{};
+    }
+
+    template <auto Field>
+    auto column()
+    {
+        using Component =
+            typename internals::MemberPointer<decltype(Field)>::Owner;
+        using Type = typename internals::MemberPointer<decltype(Field)>::Type;
+        if (auto pool = _components.find<Component>()) {
+            return pool->template column<Field>();
+        }
+        return std::span<Type>{};
+    }
+
+    /**
+     * The only instance of a component with storage::Singleton policy.
+     */
+    template <class Component>
+        requires std::same_as<StoragePolicy<Component>, storage::Singleton>
+    const Component& singleton() const
+    {
+        auto pool = _components.find<Component>();
+        if (!pool || pool->size() == 0) {
+            throw std::out_of_range{
+                "ge::thing::EntityManager::singleton: no instance"};
+        }
+        return pool->componentAt(0);
+    }
+
+    template <class Component>
+        requires std::same_as<StoragePolicy<Component>, storage::Singleton>
+    Component& singleton()
+    {
+        auto& component = const_cast<Component&>(
+            std::as_const(*this).singleton<Component>());
+        _components.at<Component>().markChanged(0);
+        return component;
+    }
+
+    template <class Component>
+    std::span<const Entity> entities() const
+    {
+        if (auto pool = _components.find<Component>()) {
+            return pool->entities();
+        }
+        return {};
+    }
+
+    /**
+     * View over entities with all of the components. Components may be
+     * wrapped into Changed<> or Added<> filters, which pass entities whose
+     * component was changed or added after the since tick. Going through a
+     * mutable view marks the visited components as changed, so code that
+     * only reads a component should take it as const T or Read<T>.
+     */
+    template <class... Terms>
+    View<internals::ConstTermOf<Terms>...> view(Tick since = 0) const
+    {
+        return View<internals::ConstTermOf<Terms>...>{
+            since,
+            _components.find<
+                std::remove_const_t<internals::TermComponent<Terms>>>()...};
+    }
+
+    template <class... Terms>
+    View<Terms...> view(Tick since = 0)
+    {
+        return View<Terms...>{
+            since,
+            _components.find<
+                std::remove_const_t<internals::TermComponent<Terms>>>()...};
+    }
+
+    /**
+     * Access tokens for using the manager from several threads. By default
+     * nothing in the manager is thread-safe; while tokens are in use:
+     *
+     * - Each thread goes through its tokens only. A read token shares the
+     *   pools of its components with other read tokens, a write token has
+     *   them to itself. Acquiring a token blocks until its pools are free,
+     *   and then reading or writing through it takes no further locks, so
+     *   tokens are best acquired once per frame or task.
+     * - Structural changes (creating or killing entities, removing
+     *   components, groups, sorting, compaction, loading) are made by one
+     *   thread at a time, through the manager, while holding the lock
+     *   returned by lockStructure(). It waits until all tokens have been
+     *   released, and keeps new ones from being acquired meanwhile.
+     *
+     * A thread holds one token at a time, of any manager, with all the
+     * components it needs, even if it only reads: tokens taken one after
+     * another could lock pools in different orders on two threads, and
+     * wait on each other through the writers queued on those pools. So a
+     * thread that reads two managers takes a token of one, then of the
+     * other. It must not acquire a token while holding the structure lock
+     * either. Tokens are released on the thread that acquired them.
+     *
+     * Throws std::logic_error if the thread holds a token, of this manager
+     * or another one.
+     */
+    template <class... Components>
+    ReadAccess<Components...> readAccess() const
+    {
+        checkNoAccess("ge::thing::EntityManager::readAccess");
+        std::shared_lock structure{_structureMutex};
+        auto pools = [this] {
+            std::lock_guard registry{_registryMutex};
+            return std::tuple{_components.find<Components>()...};
+        }();
+        return std::apply([&structure] (auto... pools) {
+            return ReadAccess<Components...>{std::move(structure), pools...};
+        }, pools);
+    }
+
+    /**
+     * Creates the pools of the components if needed. Throws
+     * std::logic_error if the thread holds a token, as readAccess() does.
+     */
+    template <class... Components>
+    WriteAccess<Components...> writeAccess()
+    {
+        checkNoAccess("ge::thing::EntityManager::writeAccess");
+        std::shared_lock structure{_structureMutex};
+        auto pools = [this] {
+            std::lock_guard registry{_registryMutex};
+            return std::tuple<internals::OneTypeComponents<Components>*...>{
+                &_components.create<Components>()...};
+        }();
+        return std::apply([this, &structure] (auto... pools) {
+            return WriteAccess<Components...>{
+                std::move(structure), _entityPool, *pools...};
+        }, pools);
+    }
+
+    /**
+     * Throws std::logic_error if the thread holds an access token, of this
+     * manager or another one.
+     */
+    std::unique_lock<internals::StructureMutex> lockStructure()
+    {
+        return std::unique_lock{_structureMutex};
+    }
+
+    /**
+     * Memory use of the entity slots and of every component pool.
+     */
+    MemoryStatistics statistics() const
+    {
+        MemoryStatistics statistics;
+        statistics.entitySlots = _entityPool.slotCount();
+        statistics.liveEntities = _entityPool.liveCount();
+        statistics.entityBytes = _entityPool.memory();
+        _components.statistics(statistics.pools);
+        return statistics;
+    }
+
+    template <class Component>
+    PoolStatistics statistics() const
+    {
+        if (auto pool = _components.find<Component>()) {
+            return pool->statistics();
+        }
+        return {componentId<Component>()};
+    }
+
+    /**
+     * Maintenance pass: move the entries of every pool into the order of
+     * their entity slots, so that iterating over several pools walks
+     * memory forward, release unused capacity, and relink the free entity
+     * slots so that new entities take the lowest ones first. Entity handles
+     * and pools owned by a group keep their order.
+     *
+     * The pass runs in steps of bounded work until the time budget is
+     * spent, and resumes from there on the next call; returns true once
+     * a whole pass has completed. A step moves or visits a bounded number
+     * of entries and slots, and reallocates at most one array. The manager
+     * can be used and modified between calls. Views and component
+     * references are invalidated.
+     */
+    bool compact(std::chrono::steady_clock::duration budget)
+    {
+        auto deadline = std::chrono::steady_clock::now() + budget;
+        do {
+            if (compactStep()) {
+                return true;
+            }
+        } while (std::chrono::steady_clock::now() < deadline);
+        return false;
+    }
+
+    /**
+     * Run a whole compaction pass at once.
+     */
+    void compact()
+    {
+        while (!compactStep()) { }
+    }
+
+    /**
+     * Hooks, called after a component was added to an entity, after add()
+     * replaced the value of one, or before one is removed, also when its
+     * entity is killed. They keep derived data such as spatial indexes up
+     * to date; see Collector for gathering the entities instead. Hooks must
+     * not make structural changes to the manager. They stay registered
+     * across load(), which does not call them.
+     */
+    template <class Component>
+    HookId onAdd(std::function<void(Entity, const Component&)> hook)
+    {
+        return _components.create<Component>().addHook(
+            ComponentEvent::Added, std::move(hook));
+    }
+
+    template <class Component>
+    HookId onReplace(std::function<void(Entity, const Component&)> hook)
+    {
+        return _components.create<Component>().addHook(
+            ComponentEvent::Replaced, std::move(hook));
+    }
+
+    template <class Component>
+    HookId onRemove(std::function<void(Entity, const Component&)> hook)
+    {
+        return _components.create<Component>().addHook(
+            ComponentEvent::Removed, std::move(hook));
+    }
+
+    template <class Component>
+    void removeHook(HookId id)
+    {
+        if (auto pool = _components.find<Component>()) {
+            pool->removeHook(id);
+        }
+    }
+
+    /**
+     * Owning group of the components: their pools are kept in the same
+     * dense order for the entities that have all of them, which come
+     * first. Created on first use; a component can be owned by one group
+     * only. Throws std::logic_error if one of them is already owned by a
+     * group of other components.
+     */
+    template <class... Owned>
+    Group<Owned...> group()
+    {
+        static_assert(sizeof...(Owned) > 1);
+        return Group<Owned...>{_components.group<Owned...>()};
+    }
+
+    /**
+     * Sort the dense order of a pool, e.g. to iterate it in the order of
+     * another pool. The comparator takes either two components or two
+     * entities. Throws std::logic_error if the pool is owned by a group.
+     */
+    template <class Component, class Compare>
+    void sort(Compare compare)
+    {
+        auto pool = _components.find<Component>();
+        if (!pool) {
+            return;
+        }
+        if (pool->group()) {
+            throw std::logic_error{
+                "ge::thing::EntityManager::sort: pool is owned by a group"};
+        }
+        pool->sort(std::move(compare));
+    }
+
+    const Hierarchy& hierarchy() const
+    {
+        return _hierarchy;
+    }
+
+    /**
+     * Make parent the parent of child, detaching child from its previous
+     * parent. Throws std::invalid_argument if either entity is dead, or if
+     * parent is child itself or one of its descendants.
+     */
+    void setParent(Entity child, Entity parent)
+    {
+        checkAlive(child);
+        checkAlive(parent);
+        _hierarchy.setParent(child, parent);
+    }
+
+    void removeParent(Entity child)
+    {
+        _hierarchy.removeParent(child);
+    }
+
+    /**
+     * The tick that changes are currently stamped with. Starts at 1.
+     */
+    Tick tick() const
+    {
+        return _components.tick();
+    }
+
+    /**
+     * Move on to the next tick, and return the previous one. A reader that
+     * keeps the returned tick and later passes it to view() sees all
+     * changes made after this call:
+     *
+     *     auto since = lastSeen;
+     *     lastSeen = manager.advanceTick();
+     *     for (auto [entity, t] : manager.view<Changed<const T>>(since)) ...
+     */
+    Tick advanceTick()
+    {
+        return _components.advanceTick();
+    }
+
+    /**
+     * Call function(Entity, Components&...) for every entity that has all
+     * of the components, in cache-sized chunks running on the thread pool.
+     * See View::parallelEach.
+     */
+    template <class... Components, class Function>
+    void parallelEach(ThreadPool& pool, Function&& function)
+    {
+        view<Components...>().parallelEach(
+            pool, std::forward<Function>(function));
+    }
+
+    template <class... Components, class Function>
+    void parallelEach(ThreadPool& pool, Function&& function) const
+    {
+        view<Components...>().parallelEach(
+            pool, std::forward<Function>(function));
+    }
+
+    template <class Component>
+    internals::ReferenceFor<Component> add(Entity entity)
+    {
+        checkAlive(entity);
+        return _components.create<Component>().add(entity);
+    }
+
+    template <class Component>
+    internals::ReferenceFor<Component> add(
+        Entity entity, Component&& component)
+    {
+        checkAlive(entity);
+        return _components.create<Component>().add(
+            entity, std::move(component));
+    }
+
+    /**
+     * Add a component to each of the entities, reserving pool capacity once.
+     * The spans must be of the same size.
+     */
+    template <class Component>
+    void addBatch(
+        std::span<const Entity> entities,
+        std::span<const Component> components)
+    {
+        if (entities.size() != components.size()) {
+            throw std::invalid_argument{
+                "ge::thing::EntityManager::addBatch: size mismatch"};
+        }
+        for (auto entity : entities) {
+            checkAlive(entity);
+        }
+        _components.create<Component>().addBatch(entities, components);
+    }
+
+    /**
+     * Add a copy of the component to each of the entities.
+     */
+    template <class Component>
+    void addBatch(std::span<const Entity> entities, const Component& component)
+    {
+        for (auto entity : entities) {
+            checkAlive(entity);
+        }
+        _components.create<Component>().addBatch(entities, component);
+    }
+
+    template <class Component>
+    void remove(Entity entity)
+    {
+        auto pool = _components.find<Component>();
+        if (pool && pool->contains(entity)) {
+            pool->killEntity(entity);
+            _journal.removed(entity, componentId<Component>());
+        }
+    }
+
+    /**
+     * Components by ID, for code that only knows them at run time, such as
+     * script bindings and editors. Values are handled by address, with the
+     * layout of their ComponentInfo. Components with storage::Columns
+     * policy have no address, and throw std::logic_error here.
+     */
+    bool has(Entity entity, ComponentId id) const
+    {
+        auto pool = _components.find(id);
+        return pool && pool->contains(entity);
+    }
+
+    /**
+     * Throws std::out_of_range if the entity does not have the component.
+     */
+    const void* component(Entity entity, ComponentId id) const
+    {
+        auto pool = _components.find(id);
+        auto value = pool ? pool->findRaw(entity) : nullptr;
+        if (!value) {
+            throw std::out_of_range{"ge::thing::EntityManager::component"};
+        }
+        return value;
+    }
+
+    /**
+     * Mutable access marks the component as changed at the current tick.
+     */
+    void* component(Entity entity, ComponentId id)
+    {
+        auto value = std::as_const(*this).component(entity, id);
+        _components.find(id)->markChanged(entity);
+        return const_cast<void*>(value);
+    }
+
+    /**
+     * Add the component, moved from the value, or default-constructed if
+     * the value is null, and return its address. The pool is created from
+     * the registered ComponentInfo if needed. Throws std::invalid_argument
+     * if the entity is not alive, and std::out_of_range if the ID is not
+     * registered.
+     */
+    void* add(Entity entity, ComponentId id, void* value = nullptr)
+    {
+        checkAlive(entity);
+        auto pool = _components.find(id);
+        if (!pool) {
+            pool = &_components.create(componentRegistry().at(id));
+        }
+        return pool->addRaw(entity, value);
+    }
+
+    void remove(Entity entity, ComponentId id)
+    {
+        auto pool = _components.find(id);
+        if (pool && pool->contains(entity)) {
+            pool->killEntity(entity);
+            _journal.removed(entity, id);
+        }
+    }
+
+    std::span<const Entity> entities(ComponentId id) const
+    {
+        auto pool = _components.find(id);
+        return pool ? pool->entities() : std::span<const Entity>{};
+    }
+
+    /**
+     * The components in the order of entities(id), as one array with the
+     * registered size as stride, e.g. for bulk operations of scripts. Null
+     * if there is no pool, or it does not store the components contiguously
+     * (Paged, Tag and Columns storage). Writes through the array are not
+     * tracked as changes.
+     */
+    const void* data(ComponentId id) const
+    {
+        auto pool = _components.find(id);
+        return pool ? pool->rawData() : nullptr;
+    }
+
+    void* data(ComponentId id)
+    {
+        return const_cast<void*>(std::as_const(*this).data(id));
+    }
+
+    Entity createEntity()
+    {
+        flushReserved();
+        auto entity = _entityPool.createEntity();
+        _journal.created(entity);
+        return entity;
+    }
+
+    /**
+     * Create an entity with the given handle, e.g. one taken from another
+     * manager. Throws std::invalid_argument if its slot is in use or
+     * holds a newer generation.
+     */
+    Entity createEntity(Entity entity)
+    {
+        flushReserved();
+        _entityPool.createEntity(entity);
+        _journal.created(entity);
+        return entity;
+    }
+
+    std::vector<Entity> createEntities(size_t count)
+    {
+        flushReserved();
+        std::vector<Entity> entities(count, Entity{0});
+        _entityPool.createEntities(entities);
+        for (auto entity : entities) {
+            _journal.created(entity);
+        }
+        return entities;
+    }
+
+    /**
+     * Create count entities, each with copies of all components of the
+     * prototype entity. Every pool is visited once for the whole batch.
+     */
+    std::vector<Entity> spawn(Entity prototype, size_t count)
+    {
+        checkAlive(prototype);
+        auto entities = createEntities(count);
+        _components.copyEntity(prototype, entities);
+        return entities;
+    }
+
+    void killEntity(Entity entity)
+    {
+        if (!_entityPool.alive(entity)) {
+            return;
+        }
+        _components.killEntity(entity);
+        _hierarchy.killEntity(entity);
+        _entityPool.killEntity(entity);
+        _journal.killed(entity);
+    }
+
+    /**
+     * Kill several entities, visiting each component pool once.
+     */
+    void killEntities(std::span<const Entity> entities)
+    {
+        _components.killEntities(entities);
+        for (auto entity : entities) {
+            if (_entityPool.alive(entity)) {
+                _hierarchy.killEntity(entity);
+                _entityPool.killEntity(entity);
+                _journal.killed(entity);
+            }
+        }
+    }
+
+    /**
+     * Move the entities with all of their components to the target manager,
+     * e.g. to stream a level chunk in or out, and return their handles
+     * there, in the same order. The entities are killed here, which drops
+     * them from the hierarchy; hooks see their components removed here and
+     * added there. Each pool is visited once for the whole batch. Throws
+     * std::invalid_argument if an entity is not alive, is listed twice, or
+     * the target is this manager.
+     */
+    std::vector<Entity> migrate(
+        std::span<const Entity> entities, EntityManager& target)
+    {
+        if (&target == this) {
+            throw std::invalid_argument{
+                "ge::thing::EntityManager::migrate: same manager"};
+        }
+        std::vector<Entity::IndexType> indices;
+        indices.reserve(entities.size());
+        for (auto entity : entities) {
+            checkAlive(entity);
+            indices.push_back(entity.index());
+        }
+        std::ranges::sort(indices);
+        if (std::ranges::adjacent_find(indices) != indices.end()) {
+            throw std::invalid_argument{
+                "ge::thing::EntityManager::migrate: duplicate entity"};
+        }
+        auto migrated = target.createEntities(entities.size());
+        _components.moveEntities(entities, target._components, migrated);
+        for (auto entity : entities) {
+            if (_entityPool.alive(entity)) {
+                _hierarchy.killEntity(entity);
+                _entityPool.killEntity(entity);
+                _journal.killed(entity);
+            }
+        }
+        return migrated;
+    }
+
+    bool alive(Entity entity) const
+    {
+        return _entityPool.alive(entity);
+    }
+
+    /**
+     * Reserve an entity handle without creating the entity. The entity
+     * becomes alive at the next structural change of the manager, e.g.
+     * createEntity() or CommandBuffer::apply(). May be called from several
+     * threads at once, while no structural changes are made.
+     */
+    Entity reserveEntity()
+    {
+        return _entityPool.reserveEntity();
+    }
+
+    void flushReserved()
+    {
+        auto first = _entityPool.slotCount();
+        _entityPool.flushReserved();
+        for (auto index = first; index < _entityPool.slotCount(); index++) {
+            _journal.created(
+                Entity{static_cast<Entity::IndexType>(index), 0});
+        }
+    }
+
+    /**
+     * Write the entities and the pools of the listed components to a
+     * versioned binary snapshot. Pools are written as raw arrays, so the
+     * components must be trivially copyable, and the snapshot can only be
+     * loaded on a machine with the same byte order and type layouts. The
+     * component list identifies the pools in the snapshot: load() must be
+     * given the same list, in the same order.
+     */
+    template <class... Components>
+    void save(std::ostream& stream) const
+    {
+        static_assert(
+            (... && std::is_trivially_copyable_v<Components>),
+            "only trivially copyable components can be saved");
+
+        internals::BlobWriter writer{stream};
+        writer.write(SnapshotMagic);
+        writer.write(SnapshotVersion);
+        writer.write(SnapshotByteOrder);
+        writer.write<uint32_t>(sizeof...(Components));
+        writer.write<uint64_t>(_components.tick());
+        _entityPool.save(writer);
+        (savePool<Components>(writer), ...);
+    }
+
+    /**
+     * Replace the whole state of the manager with a snapshot written by
+     * save(), e.g. from a MappedFile. Pool arrays are copied as a whole,
+     * without parsing entities one by one. The free list of the entity
+     * slots and the sparse indices of the pools are then checked in a
+     * linear pass each, since a corrupt snapshot would otherwise lead to
+     * reads out of bounds later. Pools of components not in the snapshot
+     * are dropped, and so is the hierarchy, which snapshots do not
+     * include. Groups are rebuilt on the loaded pools, and existing Group
+     * handles stay valid. Throws std::runtime_error if the snapshot does
+     * not match the component list or is inconsistent, in which case the
+     * manager is left unchanged.
+     */
+    template <class... Components>
+    void load(std::span<const std::byte> snapshot)
+    {
+        internals::BlobReader reader{snapshot};
+        if (reader.read<uint32_t>() != SnapshotMagic) {
+            badSnapshot("not a snapshot");
+        }
+        if (reader.read<uint32_t>() != SnapshotVersion) {
+            badSnapshot("unsupported version");
+        }
+        if (reader.read<uint32_t>() != SnapshotByteOrder) {
+            badSnapshot("foreign byte order");
+        }
+        if (reader.read<uint32_t>() != sizeof...(Components)) {
+            badSnapshot("component count mismatch");
+        }
+        auto tick = reader.read<uint64_t>();
+
+        internals::EntityPool entityPool{_components.resource()};
+        entityPool.load(reader);
+        internals::AnyTypeComponents components{_components.resource()};
+        components.setTick(tick);
+        (loadPool<Components>(reader, components), ...);
+
+        _components.moveHooks(components);
+        _components.moveGroups(components);
+        _entityPool.swap(entityPool);
+        _components = std::move(components);
+        _journal.clear();
+        _hierarchy.clear();
+    }
+
+private:
+    // "THNG" in little-endian byte order.
+    static constexpr uint32_t SnapshotMagic = 0x474e4854;
+    static constexpr uint32_t SnapshotVersion = 2;
+    static constexpr uint32_t SnapshotByteOrder = 0x01020304;
+
+    EntityManager(
+            const EntityManager& other,
+            std::pmr::memory_resource* resource)
+        : _entityPool(resource)
+        , _components(resource)
+        , _hierarchy(other._hierarchy)
+    {
+        _entityPool.assign(other._entityPool);
+        other._components.cloneInto(_components);
+    }
+
+    template <class Component>
+    void savePool(internals::BlobWriter& writer) const
+    {
+        writer.write<uint32_t>(sizeof(Component));
+        writer.write<uint32_t>(alignof(Component));
+        auto pool = _components.find<Component>();
+        writer.write<uint8_t>(pool ? 1 : 0);
+        if (pool) {
+            pool->save(writer);
+        }
+    }
+
+    template <class Component>
+    static void loadPool(
+        internals::BlobReader& reader,
+        internals::AnyTypeComponents& components)
+    {
+        if (reader.read<uint32_t>() != sizeof(Component) ||
+                reader.read<uint32_t>() != alignof(Component)) {
+            badSnapshot("component layout mismatch");
+        }
+        if (reader.read<uint8_t>()) {
+            components.create<Component>().load(reader);
+        }
+    }
+
+    [[noreturn]] static void badSnapshot(const char* reason)
+    {
+        throw std::runtime_error{
+            std::string{"ge::thing::EntityManager::load: "} + reason};
+    }
+
+    template <class Component>
+    friend class internals::Commands;
+
+    template <class... Components>
+    friend class DeltaEncoder;
+
+    template <class... Components>
+    friend void applyDelta(EntityManager&, std::span<const std::byte>);
+
+    // See EntityPool::claimEntity().
+    bool claimEntity(Entity entity, size_t slotLimit)
+    {
+        bool linked = _entityPool.claimEntity(entity, slotLimit);
+        _journal.created(entity);
+        return linked;
+    }
+
+    bool compactStep()
+    {
+        constexpr size_t StepSize = 1024;
+
+        size_t budget = StepSize;
+        if (!_components.compact(_compactPool, _compaction, budget)) {
+            return false;
+        }
+        flushReserved();
+        if (budget == 0) {
+            return false;
+        }
+        auto slots = budget;
+        bool relinked = _entityPool.compact(budget);
+        _journal.relinked(slots - budget);
+        if (!relinked) {
+            return false;
+        }
+        _compactPool = 0;
+        _compaction = {};
+        return true;
+    }
+
+    static void checkNoAccess(const char* function)
+    {
+        if (internals::StructureMutex::heldByThread()) {
+            throw std::logic_error{
+                std::string{function} + ": the thread holds an access token"};
+        }
+    }
+
+    void checkAlive(Entity entity) const
+    {
+        if (!_entityPool.alive(entity)) {
+            throw std::invalid_argument{
+                "ge::thing::EntityManager: entity is not alive"};
+        }
+    }
+
+    internals::EntityPool _entityPool;
+    internals::AnyTypeComponents _components;
+    internals::Journal _journal;
+    Hierarchy _hierarchy;
+
+    ComponentId _compactPool = 0;
+    internals::PoolCompaction _compaction;
+
+    // Held shared by access tokens, and exclusively for structural changes
+    // while tokens are in use. Pools are looked up under the registry
+    // mutex, since write tokens may create them.
+    mutable internals::StructureMutex _structureMutex;
+    mutable std::mutex _registryMutex;
+};
+
+} // namespace ge::thing
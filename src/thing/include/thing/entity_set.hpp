@@ -0,0 +1,89 @@
+#pragma once
+
+#include <thing/entity.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace ge::thing::internals {
+
+/**
+ * Unordered set of entities with constant-time insertion, removal, and
+ * lookup, stored densely for iteration. Positions are indexed by entity
+ * slot; an entity of an older generation in the same slot does not count
+ * as contained.
+ */
+class EntitySet {
+public:
+    std::span<const Entity> entities() const
+    {
+        return _entities;
+    }
+
+    size_t size() const
+    {
+        return _entities.size();
+    }
+
+    bool empty() const
+    {
+        return _entities.empty();
+    }
+
+    bool contains(Entity entity) const
+    {
+        auto slot = entity.index();
+        return slot < _positions.size() &&
+            _positions[slot] != NoPosition &&
+            _entities[_positions[slot]] == entity;
+    }
+
+    void insert(Entity entity)
+    {
+        if (contains(entity)) {
+            return;
+        }
+        if (_positions.size() <= entity.index()) {
+            _positions.resize(entity.index() + size_t{1}, NoPosition);
+        }
+        _positions[entity.index()] = static_cast<uint32_t>(_entities.size());
+        _entities.push_back(entity);
+    }
+
+    /**
+     * The last entity takes the place of the erased one.
+     */
+    void erase(Entity entity)
+    {
+        if (!contains(entity)) {
+            return;
+        }
+        auto position = _positions[entity.index()];
+        auto last = _entities.back();
+        _entities[position] = last;
+        _positions[last.index()] = position;
+        _positions[entity.index()] = NoPosition;
+        _entities.pop_back();
+    }
+
+    void clear()
+    {
+        for (auto entity : _entities) {
+            _positions[entity.index()] = NoPosition;
+        }
+        _entities.clear();
+    }
+
+private:
+    static constexpr uint32_t NoPosition =
+        std::numeric_limits<uint32_t>::max();
+
+    std::vector<Entity> _entities;
+    // Position in _entities by entity slot, or NoPosition.
+    std::vector<uint32_t> _positions;
+};
+
+} // namespace ge::thing::internals
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <thing/components.hpp>
+#include <thing/entity.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <tuple>
+#include <utility>
+
+namespace ge::thing {
+
+/**
+ * Iterates over the entities of an owning group: the first size() entries of
+ * every owned pool, which hold the same entities in the same order. No pool
+ * is probed; all of them are walked in lockstep. Yields
+ * (Entity, Owned&...) tuples.
+ */
+template <class... Owned>
+class Group {
+public:
+    using value_type = std::tuple<Entity, internals::ReferenceFor<Owned>...>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = Group::value_type;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        Iterator(const Group* group, size_t index)
+            : _group(group)
+            , _index(index)
+        { }
+
+        value_type operator*() const
+        {
+            return _group->get(_index);
+        }
+
+        Iterator& operator++()
+        {
+            ++_index;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs)
+        {
+            return lhs._index == rhs._index;
+        }
+
+    private:
+        const Group* _group = nullptr;
+        size_t _index = 0;
+    };
+
+    explicit Group(internals::OwningGroup<Owned...>& group)
+        : _group(&group)
+    { }
+
+    Iterator begin() const
+    {
+        return Iterator{this, 0};
+    }
+
+    Iterator end() const
+    {
+        return Iterator{this, size()};
+    }
+
+    size_t size() const
+    {
+        return _group->size();
+    }
+
+    std::span<const Entity> entities() const
+    {
+        return _group->template pool<First>().entities().first(size());
+    }
+
+    /**
+     * The components of the group's entities, in the order of entities().
+     * Writes through the span are not tracked as changes.
+     */
+    template <class Component>
+    std::span<Component> components() const
+    {
+        return _group->template pool<Component>().components().first(size());
+    }
+
+    template <class Function>
+    void each(Function&& function) const
+    {
+        for (size_t index = 0; index < size(); index++) {
+            std::apply(function, get(index));
+        }
+    }
+
+private:
+    using First = std::tuple_element_t<0, std::tuple<Owned...>>;
+
+    value_type get(size_t index) const
+    {
+        return value_type{
+            _group->template pool<First>().entities()[index],
+            _group->template pool<Owned>().componentAt(index)...};
+    }
+
+    internals::OwningGroup<Owned...>* _group;
+};
+
+} // namespace ge::thing
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <thing/entity.hpp>
+#include <thing/thread_pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+class EntityManager;
+
+/**
+ * Position of a node in the breadth-first order. The children of a node are
+ * the childCount nodes starting at firstChild, and every node comes after
+ * its parent.
+ */
+struct BreadthFirstNode {
+    static constexpr uint32_t NoParent = std::numeric_limits<uint32_t>::max();
+
+    Entity entity;
+    uint32_t parent;
+    uint32_t firstChild;
+    uint32_t childCount;
+};
+
+/**
+ * Position of a node in the depth-first (pre-)order. The subtree of a node
+ * is the range from the node itself up to subtreeEnd.
+ */
+struct DepthFirstNode {
+    static constexpr uint32_t NoParent = std::numeric_limits<uint32_t>::max();
+
+    Entity entity;
+    uint32_t parent;
+    uint32_t subtreeEnd;
+};
+
+/**
+ * Parent-child relationships between entities of an entity manager. An
+ * entity is a node of the hierarchy while it has a parent or children;
+ * nodes without a parent are roots. Children keep the order in which they
+ * were attached.
+ *
+ * The breadth-first and depth-first orders are flat arrays, rebuilt on the
+ * first access after the hierarchy changed. Parents come before their
+ * children in both, so propagating e.g. world transforms is a single
+ * linear sweep. The rebuild is not thread-safe: access the orders once
+ * from one thread before sharing them.
+ */
+class Hierarchy {
+public:
+    std::optional<Entity> parent(Entity entity) const
+    {
+        auto links = find(entity);
+        if (!links || links->parent == NoSlot) {
+            return std::nullopt;
+        }
+        return _links[links->parent].entity;
+    }
+
+    bool contains(Entity entity) const
+    {
+        return find(entity) != nullptr;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    std::span<const BreadthFirstNode> breadthFirst() const
+    {
+        update();
+        return _breadthFirst;
+    }
+
+    std::span<const DepthFirstNode> depthFirst() const
+    {
+        update();
+        return _depthFirst;
+    }
+
+    /**
+     * The children of the entity, as a contiguous range of the
+     * breadth-first order.
+     */
+    std::span<const BreadthFirstNode> children(Entity entity) const
+    {
+        if (!find(entity)) {
+            return {};
+        }
+        update();
+        const auto& node = _breadthFirst[_positions[entity.index()]];
+        return std::span{_breadthFirst}.subspan(
+            node.firstChild, node.childCount);
+    }
+
+    /**
+     * Call function(position, node) for every node of the depth-first
+     * order, on the thread pool. A node is always visited before its
+     * children; subtrees are visited concurrently. Subtrees of up to
+     * grainSize nodes are batched into a single task, and larger ones are
+     * split at their children.
+     */
+    template <class Function>
+    void parallelDepthFirst(
+        ThreadPool& pool, Function&& function, size_t grainSize = 1024) const
+    {
+        auto nodes = depthFirst();
+        TaskGroup group{pool};
+        auto visit = [&] (auto& self, size_t first, size_t last) -> void {
+            auto flush = [&] (size_t from, size_t to) {
+                if (from < to) {
+                    group.run([&function, nodes, from, to] {
+                        for (auto position = from; position < to;
+                                position++) {
+                            function(position, nodes[position]);
+                        }
+                    });
+                }
+            };
+
+            auto batch = first;
+            for (auto position = first; position < last; ) {
+                size_t end = nodes[position].subtreeEnd;
+                if (end - position > grainSize) {
+                    flush(batch, position);
+                    function(position, nodes[position]);
+                    group.run([&self, position, end] {
+                        self(self, position + 1, end);
+                    });
+                    batch = end;
+                } else if (end - batch > grainSize) {
+                    flush(batch, position);
+                    batch = position;
+                }
+                position = end;
+            }
+            flush(batch, last);
+        };
+        visit(visit, 0, nodes.size());
+        group.wait();
+    }
+
+private:
+    friend class EntityManager;
+
+    static constexpr uint32_t NoSlot = std::numeric_limits<uint32_t>::max();
+
+    // Indexed by entity slot. Siblings form a doubly linked list.
+    struct Links {
+        Entity entity {0};
+        bool node = false;
+        uint32_t parent = NoSlot;
+        uint32_t firstChild = NoSlot;
+        uint32_t lastChild = NoSlot;
+        uint32_t previous = NoSlot;
+        uint32_t next = NoSlot;
+    };
+
+    /**
+     * Throws std::invalid_argument if the parent is the child itself, or
+     * one of its descendants.
+     */
+    void setParent(Entity child, Entity parent)
+    {
+        for (auto ancestor = find(parent); ancestor;
+                ancestor = ancestor->parent == NoSlot ?
+                    nullptr : &_links[ancestor->parent]) {
+            if (ancestor->entity == child) {
+                throw std::invalid_argument{
+                    "ge::thing::Hierarchy::setParent: cycle"};
+            }
+        }
+        if (child == parent) {
+            throw std::invalid_argument{
+                "ge::thing::Hierarchy::setParent: cycle"};
+        }
+
+        auto slots = std::max(child.index(), parent.index()) + size_t{1};
+        if (_links.size() < slots) {
+            _links.resize(slots);
+        }
+        auto& childLinks = attach(child);
+        auto& parentLinks = attach(parent);
+        auto oldParent = childLinks.parent;
+        detach(childLinks);
+        if (oldParent != NoSlot && oldParent != parent.index()) {
+            release(_links[oldParent]);
+        }
+
+        auto childSlot = child.index();
+        auto parentSlot = parent.index();
+        childLinks.parent = parentSlot;
+        childLinks.previous = parentLinks.lastChild;
+        if (parentLinks.lastChild == NoSlot) {
+            parentLinks.firstChild = childSlot;
+        } else {
+            _links[parentLinks.lastChild].next = childSlot;
+        }
+        parentLinks.lastChild = childSlot;
+        _dirty = true;
+    }
+
+    void removeParent(Entity child)
+    {
+        if (auto links = find(child)) {
+            auto parent = links->parent;
+            detach(*links);
+            release(*links);
+            if (parent != NoSlot) {
+                release(_links[parent]);
+            }
+            _dirty = true;
+        }
+    }
+
+    /**
+     * Remove the entity from the hierarchy. Its children lose their parent.
+     */
+    void killEntity(Entity entity)
+    {
+        auto links = find(entity);
+        if (!links) {
+            return;
+        }
+        auto parent = links->parent;
+        detach(*links);
+        if (parent != NoSlot) {
+            release(_links[parent]);
+        }
+        for (auto slot = links->firstChild; slot != NoSlot; ) {
+            auto& child = _links[slot];
+            slot = child.next;
+            child.parent = child.previous = child.next = NoSlot;
+            release(child);
+        }
+        links->firstChild = links->lastChild = NoSlot;
+        release(*links);
+        _dirty = true;
+    }
+
+    void clear()
+    {
+        _links.clear();
+        _size = 0;
+        _dirty = true;
+    }
+
+    const Links* find(Entity entity) const
+    {
+        auto slot = entity.index();
+        if (slot >= _links.size() || !_links[slot].node ||
+                _links[slot].entity != entity) {
+            return nullptr;
+        }
+        return &_links[slot];
+    }
+
+    Links* find(Entity entity)
+    {
+        return const_cast<Links*>(std::as_const(*this).find(entity));
+    }
+
+    // The slot must exist already.
+    Links& attach(Entity entity)
+    {
+        auto& links = _links[entity.index()];
+        if (!links.node) {
+            links = Links{entity, true};
+            ++_size;
+        }
+        return links;
+    }
+
+    // Unlink from the parent, if any.
+    void detach(Links& links)
+    {
+        if (links.parent == NoSlot) {
+            return;
+        }
+        auto& parent = _links[links.parent];
+        if (links.previous == NoSlot) {
+            parent.firstChild = links.next;
+        } else {
+            _links[links.previous].next = links.next;
+        }
+        if (links.next == NoSlot) {
+            parent.lastChild = links.previous;
+        } else {
+            _links[links.next].previous = links.previous;
+        }
+        links.parent = links.previous = links.next = NoSlot;
+    }
+
+    // Drop the entity from the hierarchy once it has no relationships left.
+    void release(Links& links)
+    {
+        if (links.node && links.parent == NoSlot &&
+                links.firstChild == NoSlot) {
+            links.node = false;
+            --_size;
+        }
+    }
+
+    void update() const
+    {
+        if (!_dirty) {
+            return;
+        }
+
+        _breadthFirst.clear();
+        _depthFirst.clear();
+        _positions.resize(_links.size());
+
+        for (const auto& links : _links) {
+            if (links.node && links.parent == NoSlot) {
+                _breadthFirst.push_back({
+                    links.entity, BreadthFirstNode::NoParent, 0, 0});
+            }
+        }
+        for (size_t position = 0; position < _breadthFirst.size();
+                position++) {
+            auto entity = _breadthFirst[position].entity;
+            _positions[entity.index()] = static_cast<uint32_t>(position);
+            auto first = static_cast<uint32_t>(_breadthFirst.size());
+            for (auto slot = _links[entity.index()].firstChild;
+                    slot != NoSlot; slot = _links[slot].next) {
+                _breadthFirst.push_back({
+                    _links[slot].entity,
+                    static_cast<uint32_t>(position), 0, 0});
+            }
+            auto& node = _breadthFirst[position];
+            node.firstChild = first;
+            node.childCount =
+                static_cast<uint32_t>(_breadthFirst.size()) - first;
+        }
+
+        // Pre-order walk with an explicit stack of (slot, parent position).
+        std::vector<std::pair<uint32_t, uint32_t>> stack;
+        for (auto root = _breadthFirst.rbegin();
+                root != _breadthFirst.rend(); ++root) {
+            if (root->parent == BreadthFirstNode::NoParent) {
+                stack.emplace_back(
+                    root->entity.index(), DepthFirstNode::NoParent);
+            }
+        }
+        while (!stack.empty()) {
+            auto [slot, parent] = stack.back();
+            stack.pop_back();
+            auto position = static_cast<uint32_t>(_depthFirst.size());
+            _depthFirst.push_back(
+                {_links[slot].entity, parent, position + 1});
+            for (auto child = _links[slot].lastChild; child != NoSlot;
+                    child = _links[child].previous) {
+                stack.emplace_back(child, position);
+            }
+        }
+        for (auto position = _depthFirst.size(); position-- > 0; ) {
+            const auto& node = _depthFirst[position];
+            if (node.parent != DepthFirstNode::NoParent) {
+                auto& parent = _depthFirst[node.parent];
+                parent.subtreeEnd =
+                    std::max(parent.subtreeEnd, node.subtreeEnd);
+            }
+        }
+
+        _dirty = false;
+    }
+
+    std::vector<Links> _links;
+    size_t _size = 0;
+
+    mutable bool _dirty = false;
+    mutable std::vector<BreadthFirstNode> _breadthFirst;
+    mutable std::vector<DepthFirstNode> _depthFirst;
+    mutable std::vector<uint32_t> _positions;
+};
+
+} // namespace ge::thing
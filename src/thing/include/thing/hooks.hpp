@@ -0,0 +1,81 @@
+#pragma once
+
+#include <thing/entity.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+using HookId = uint64_t;
+
+enum class ComponentEvent : uint8_t {
+    // After a component was added to an entity.
+    Added,
+    // After add() assigned a new value to an existing component. Writes
+    // through references are not events; see Changed<> views for those.
+    Replaced,
+    // Before a component is removed, also when its entity is killed.
+    Removed,
+};
+
+namespace internals {
+
+/**
+ * Functions called on the events of one pool, in the order they were
+ * registered.
+ */
+template <class Component>
+class ComponentHooks {
+public:
+    using Hook = std::function<void(Entity, const Component&)>;
+
+    HookId add(ComponentEvent event, Hook hook)
+    {
+        auto id = _nextId++;
+        _hooks[index(event)].emplace_back(id, std::move(hook));
+        return id;
+    }
+
+    void remove(HookId id)
+    {
+        for (auto& hooks : _hooks) {
+            std::erase_if(hooks, [id] (const auto& hook) {
+                return hook.first == id;
+            });
+        }
+    }
+
+    bool empty() const
+    {
+        return std::all_of(_hooks.begin(), _hooks.end(), [] (auto& hooks) {
+            return hooks.empty();
+        });
+    }
+
+    void notify(
+        ComponentEvent event, Entity entity, const Component& component) const
+    {
+        for (const auto& [id, hook] : _hooks[index(event)]) {
+            hook(entity, component);
+        }
+    }
+
+private:
+    static size_t index(ComponentEvent event)
+    {
+        return static_cast<size_t>(event);
+    }
+
+    std::array<std::vector<std::pair<HookId, Hook>>, 3> _hooks;
+    HookId _nextId = 0;
+};
+
+} // namespace internals
+
+} // namespace ge::thing
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <thing/component_id.hpp>
+#include <thing/entity.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ge::thing::internals {
+
+/**
+ * Structural changes of an entity manager that change ticks cannot
+ * express: created and killed entities, removed components, and the steps
+ * of relinking the free entity slots. Only recorded while enabled. The
+ * events are kept in the order they happened.
+ */
+class Journal {
+public:
+    enum class Kind : uint8_t {
+        Created,
+        Killed,
+        Removed,
+        Relinked,
+    };
+
+    struct Event {
+        Kind kind;
+        Entity entity;
+        // For Relinked, the number of slots the step went through.
+        ComponentId component;
+    };
+
+    bool enabled() const
+    {
+        return _enabled;
+    }
+
+    /**
+     * Disabling also drops the recorded events.
+     */
+    void enable(bool enabled)
+    {
+        _enabled = enabled;
+        if (!enabled) {
+            _events.clear();
+        }
+    }
+
+    void created(Entity entity)
+    {
+        if (_enabled) {
+            _events.push_back({Kind::Created, entity, 0});
+        }
+    }
+
+    void killed(Entity entity)
+    {
+        if (_enabled) {
+            _events.push_back({Kind::Killed, entity, 0});
+        }
+    }
+
+    void removed(Entity entity, ComponentId component)
+    {
+        if (_enabled) {
+            _events.push_back({Kind::Removed, entity, component});
+        }
+    }
+
+    /**
+     * A step of EntityPool::compact() that went through the given number
+     * of slots. Replaying the steps keeps the free list of a mirror in the
+     * order of the source.
+     */
+    void relinked(size_t slots)
+    {
+        if (_enabled) {
+            _events.push_back({Kind::Relinked, Entity{0}, slots});
+        }
+    }
+
+    std::span<const Event> events() const
+    {
+        return _events;
+    }
+
+    /**
+     * Drop the recorded events, keeping the capacity for the next ones.
+     */
+    void clear()
+    {
+        _events.clear();
+    }
+
+private:
+    bool _enabled = false;
+    std::vector<Event> _events;
+};
+
+} // namespace ge::thing::internals
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define GE_THING_HAS_MMAP 1
+#else
+    #include <fstream>
+    #include <iterator>
+    #include <vector>
+#endif
+
+namespace ge::thing {
+
+/**
+ * Read-only view of a whole file, e.g. for EntityManager::load(). The file
+ * is memory-mapped where the platform supports it, and read into memory
+ * otherwise.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+#ifdef GE_THING_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            fail("open", errno);
+        }
+        struct stat status {};
+        if (::fstat(fd, &status) != 0) {
+            auto error = errno;
+            ::close(fd);
+            fail("fstat", error);
+        }
+        _size = static_cast<size_t>(status.st_size);
+        if (_size > 0) {
+            _data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (_data == MAP_FAILED) {
+                auto error = errno;
+                _data = nullptr;
+                ::close(fd);
+                fail("mmap", error);
+            }
+            ::madvise(_data, _size, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+#else
+        std::ifstream stream{path, std::ios::binary};
+        if (!stream) {
+            throw std::system_error{
+                std::make_error_code(std::errc::io_error),
+                "ge::thing::MappedFile: open"};
+        }
+        stream.seekg(0, std::ios::end);
+        _buffer.resize(static_cast<size_t>(stream.tellg()));
+        stream.seekg(0);
+        stream.read(
+            reinterpret_cast<char*>(_buffer.data()),
+            static_cast<std::streamsize>(_buffer.size()));
+        if (!stream) {
+            throw std::system_error{
+                std::make_error_code(std::errc::io_error),
+                "ge::thing::MappedFile: read"};
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+#ifdef GE_THING_HAS_MMAP
+        : _data(std::exchange(other._data, nullptr))
+        , _size(std::exchange(other._size, 0))
+#else
+        : _buffer(std::move(other._buffer))
+#endif
+    { }
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+#ifdef GE_THING_HAS_MMAP
+            unmap();
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+#else
+            _buffer = std::move(other._buffer);
+#endif
+        }
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+#ifdef GE_THING_HAS_MMAP
+        unmap();
+#endif
+    }
+
+    std::span<const std::byte> bytes() const
+    {
+#ifdef GE_THING_HAS_MMAP
+        return {static_cast<const std::byte*>(_data), _size};
+#else
+        return _buffer;
+#endif
+    }
+
+private:
+#ifdef GE_THING_HAS_MMAP
+    [[noreturn]] static void fail(const char* what, int error)
+    {
+        throw std::system_error{
+            error,
+            std::generic_category(),
+            std::string{"ge::thing::MappedFile: "} + what};
+    }
+
+    void unmap()
+    {
+        if (_data) {
+            ::munmap(_data, _size);
+            _data = nullptr;
+        }
+    }
+
+    void* _data = nullptr;
+    size_t _size = 0;
+#else
+    std::vector<std::byte> _buffer;
+#endif
+};
+
+} // namespace ge::thing
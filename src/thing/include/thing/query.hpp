@@ -0,0 +1,341 @@
+#pragma once
+
+#include <thing/component_id.hpp>
+#include <thing/entity.hpp>
+#include <thing/entity_manager.hpp>
+#include <thing/entity_set.hpp>
+#include <thing/hooks.hpp>
+#include <thing/term.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+/**
+ * Query terms: entities must have the component (also the meaning of a bare
+ * component type), must not have it, or may have it. As in views, the
+ * component of With and Optional terms is read for const T or Read<T>.
+ */
+template <class Component>
+struct With {};
+
+template <class Component>
+struct Without {};
+
+template <class Component>
+struct Optional {};
+
+namespace internals {
+
+enum class QueryRole {
+    With,
+    Without,
+    Optional,
+};
+
+template <class Term>
+struct QueryTerm {
+    using Component = AccessType<Term>;
+    static constexpr QueryRole role = QueryRole::With;
+};
+
+template <class Term>
+struct QueryTerm<With<Term>> {
+    using Component = AccessType<Term>;
+    static constexpr QueryRole role = QueryRole::With;
+};
+
+template <class Term>
+struct QueryTerm<Without<Term>> {
+    using Component = Term;
+    static constexpr QueryRole role = QueryRole::Without;
+};
+
+template <class Term>
+struct QueryTerm<Optional<Term>> {
+    using Component = AccessType<Term>;
+    static constexpr QueryRole role = QueryRole::Optional;
+};
+
+/**
+ * What a query yields for a term: Component& for With, Component* for
+ * Optional, and nothing for Without.
+ */
+template <class Term>
+using QueryValue = std::conditional_t<
+    QueryTerm<Term>::role == QueryRole::With,
+    std::tuple<ReferenceFor<typename QueryTerm<Term>::Component>>,
+    std::conditional_t<
+        QueryTerm<Term>::role == QueryRole::Optional,
+        std::tuple<typename QueryTerm<Term>::Component*>,
+        std::tuple<>>>;
+
+} // namespace internals
+
+/**
+ * Cached query: the set of entities that match the terms, e.g.
+ * Query<Enemy, Without<Dead>, Optional<Shield>>. The set is kept up to date
+ * by hooks on the pools of the terms, so a query costs the iteration over
+ * its matches, whatever the number of entities that were looked at to find
+ * them. Yields (Entity, Component&..., Optional*...) tuples in the order of
+ * the terms, leaving out Without terms. Going through a mutable term marks
+ * the component as changed, as with views; terms that are only read should
+ * be const T or Read<T>.
+ *
+ * The order of the matches is unspecified. Adding or removing components of
+ * the terms while iterating over the query invalidates the iteration. After
+ * EntityManager::load(), which does not call hooks, call rebuild(). The
+ * query registers hooks with the manager, which must outlive it.
+ */
+template <class... Terms>
+class Query {
+    static_assert(
+        (... || (internals::QueryTerm<Terms>::role ==
+            internals::QueryRole::With)),
+        "a query needs at least one With term");
+
+public:
+    using value_type = decltype(std::tuple_cat(
+        std::declval<std::tuple<Entity>>(),
+        std::declval<internals::QueryValue<Terms>>()...));
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = Query::value_type;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        Iterator(const Query* query, size_t position)
+            : _query(query)
+            , _position(position)
+        { }
+
+        value_type operator*() const
+        {
+            return _query->get(_query->_matches.entities()[_position]);
+        }
+
+        Iterator& operator++()
+        {
+            ++_position;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs)
+        {
+            return lhs._position == rhs._position;
+        }
+
+    private:
+        const Query* _query = nullptr;
+        size_t _position = 0;
+    };
+
+    explicit Query(EntityManager& manager)
+        : _manager(manager)
+    {
+        (registerHooks<Terms>(), ...);
+        rebuild();
+    }
+
+    Query(const Query&) = delete;
+    Query& operator=(const Query&) = delete;
+
+    ~Query()
+    {
+        auto hook = _hooks.begin();
+        ((removeHooks<Terms>(hook)), ...);
+    }
+
+    Iterator begin() const
+    {
+        return Iterator{this, 0};
+    }
+
+    Iterator end() const
+    {
+        return Iterator{this, size()};
+    }
+
+    size_t size() const
+    {
+        return _matches.size();
+    }
+
+    bool empty() const
+    {
+        return _matches.empty();
+    }
+
+    bool contains(Entity entity) const
+    {
+        return _matches.contains(entity);
+    }
+
+    std::span<const Entity> entities() const
+    {
+        return _matches.entities();
+    }
+
+    template <class Function>
+    void each(Function&& function) const
+    {
+        for (auto entity : _matches.entities()) {
+            std::apply(function, get(entity));
+        }
+    }
+
+    /**
+     * Recompute the matches from the pools.
+     */
+    void rebuild()
+    {
+        _matches.clear();
+        std::span<const Entity> smallest;
+        bool found = false;
+        auto consider = [&] (std::span<const Entity> entities) {
+            if (!found || entities.size() < smallest.size()) {
+                smallest = entities;
+                found = true;
+            }
+        };
+        (... , (internals::QueryTerm<Terms>::role ==
+                    internals::QueryRole::With ?
+                consider(_manager.entities<Component<Terms>>()) :
+                void()));
+        for (auto entity : smallest) {
+            update(entity, NoComponent);
+        }
+    }
+
+private:
+    static constexpr ComponentId NoComponent =
+        std::numeric_limits<ComponentId>::max();
+
+    template <class Term>
+    using Component = std::remove_const_t<
+        typename internals::QueryTerm<Term>::Component>;
+
+    template <class Term>
+    void registerHooks()
+    {
+        using Type = Component<Term>;
+        constexpr auto role = internals::QueryTerm<Term>::role;
+        if constexpr (role == internals::QueryRole::With) {
+            _hooks.push_back(_manager.onAdd<Type>(
+                [this] (Entity entity, const Type&) {
+                    update(entity, NoComponent);
+                }));
+            _hooks.push_back(_manager.onRemove<Type>(
+                [this] (Entity entity, const Type&) {
+                    _matches.erase(entity);
+                }));
+        } else if constexpr (role == internals::QueryRole::Without) {
+            _hooks.push_back(_manager.onAdd<Type>(
+                [this] (Entity entity, const Type&) {
+                    _matches.erase(entity);
+                }));
+            _hooks.push_back(_manager.onRemove<Type>(
+                [this] (Entity entity, const Type&) {
+                    // Still there while the hook runs.
+                    update(entity, componentId<Type>());
+                }));
+        }
+    }
+
+    template <class Term>
+    void removeHooks(std::vector<HookId>::iterator& hook)
+    {
+        if constexpr (internals::QueryTerm<Term>::role !=
+                internals::QueryRole::Optional) {
+            _manager.removeHook<Component<Term>>(*hook++);
+            _manager.removeHook<Component<Term>>(*hook++);
+        }
+    }
+
+    // Insert or erase the entity, as if it did not have the absent
+    // component.
+    void update(Entity entity, ComponentId absent)
+    {
+        if ((... && matches<Terms>(entity, absent))) {
+            _matches.insert(entity);
+        } else {
+            _matches.erase(entity);
+        }
+    }
+
+    template <class Term>
+    bool matches(Entity entity, ComponentId absent) const
+    {
+        using Type = Component<Term>;
+        constexpr auto role = internals::QueryTerm<Term>::role;
+        if constexpr (role == internals::QueryRole::With) {
+            return componentId<Type>() != absent &&
+                _manager.has<Type>(entity);
+        } else if constexpr (role == internals::QueryRole::Without) {
+            return componentId<Type>() == absent ||
+                !_manager.has<Type>(entity);
+        } else {
+            return true;
+        }
+    }
+
+    value_type get(Entity entity) const
+    {
+        return std::tuple_cat(
+            std::tuple<Entity>{entity}, value<Terms>(entity)...);
+    }
+
+    template <class Term>
+    internals::QueryValue<Term> value(Entity entity) const
+    {
+        using Type = typename internals::QueryTerm<Term>::Component;
+        constexpr auto role = internals::QueryTerm<Term>::role;
+        if constexpr (role == internals::QueryRole::With) {
+            return internals::QueryValue<Term>{component<Type>(entity)};
+        } else if constexpr (role == internals::QueryRole::Optional) {
+            static_assert(
+                std::is_reference_v<internals::ReferenceFor<Type>>,
+                "optional terms cannot refer to proxies");
+            return internals::QueryValue<Term>{
+                _manager.has<std::remove_const_t<Type>>(entity) ?
+                    &component<Type>(entity) : nullptr};
+        } else {
+            return {};
+        }
+    }
+
+    template <class Type>
+    internals::ReferenceFor<Type> component(Entity entity) const
+    {
+        if constexpr (std::is_const_v<Type>) {
+            return std::as_const(_manager).template component<
+                std::remove_const_t<Type>>(entity);
+        } else {
+            return _manager.component<Type>(entity);
+        }
+    }
+
+    EntityManager& _manager;
+    std::vector<HookId> _hooks;
+    internals::EntitySet _matches;
+};
+
+} // namespace ge::thing
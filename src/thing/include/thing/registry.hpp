@@ -0,0 +1,214 @@
+#pragma once
+
+#include <thing/component_id.hpp>
+#include <thing/tick.hpp>
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+namespace internals {
+
+class AbstractComponents;
+
+template <class Component>
+std::unique_ptr<AbstractComponents> createPool(
+    std::shared_ptr<const Clock> clock,
+    std::pmr::memory_resource* resource);
+
+} // namespace internals
+
+/**
+ * Layout and lifetime of a component type, for code that handles components
+ * by ID at run time, such as script bindings and editors. C++ types are
+ * described by of<Component>(). Types defined at run time fill in the
+ * layout, and the functions unless their values are plain bytes.
+ */
+struct ComponentInfo {
+    using CreatePool = std::unique_ptr<internals::AbstractComponents> (*)(
+        std::shared_ptr<const internals::Clock>,
+        std::pmr::memory_resource*);
+
+    ComponentId id = 0;
+    std::string name;
+    size_t size = 0;
+    size_t alignment = 1;
+
+    // Default-construct, copy-construct, move-construct (leaving the source
+    // to be destroyed) and destroy the value at an address. They must not
+    // throw. Null functions zero the bytes, copy them, copy them, and do
+    // nothing, respectively.
+    void (*construct)(void* address) = nullptr;
+    void (*copy)(void* target, const void* source) = nullptr;
+    void (*move)(void* target, void* source) = nullptr;
+    void (*destroy)(void* address) = nullptr;
+
+    // Creates the typed pool of a C++ type. Null for types defined at run
+    // time, which are stored in pools of raw bytes.
+    CreatePool createPool = nullptr;
+
+    template <class Component>
+    static ComponentInfo of(std::string name)
+    {
+        ComponentInfo info;
+        info.id = componentId<Component>();
+        info.name = std::move(name);
+        info.size = sizeof(Component);
+        info.alignment = alignof(Component);
+        if constexpr (std::default_initializable<Component>) {
+            info.construct = [] (void* address) {
+                new (address) Component{};
+            };
+        }
+        if constexpr (std::copy_constructible<Component>) {
+            info.copy = [] (void* target, const void* source) {
+                new (target) Component(
+                    *static_cast<const Component*>(source));
+            };
+        }
+        if constexpr (std::move_constructible<Component>) {
+            info.move = [] (void* target, void* source) {
+                new (target) Component(
+                    std::move(*static_cast<Component*>(source)));
+            };
+        }
+        info.destroy = [] (void* address) {
+            static_cast<Component*>(address)->~Component();
+        };
+        info.createPool = &internals::createPool<Component>;
+        return info;
+    }
+};
+
+/**
+ * The component types known by name. Types defined at run time get their
+ * IDs from the same sequence as C++ types, so both index the pools of the
+ * entity manager alike. Types cannot be unregistered, and their infos stay
+ * at the same address for the lifetime of the registry. May be used from
+ * several threads at once.
+ */
+class ComponentRegistry {
+public:
+    /**
+     * Register a C++ type under a name, and return its ID. Registering it
+     * again under the same name does nothing. Throws std::invalid_argument
+     * if the type or the name is already registered otherwise.
+     */
+    template <class Component>
+    ComponentId add(std::string name)
+    {
+        std::unique_lock lock{_mutex};
+        auto id = componentId<Component>();
+        if (auto known = findLocked(id)) {
+            if (known->name != name) {
+                throw std::invalid_argument{
+                    "ge::thing::ComponentRegistry::add: "
+                    "type is registered under another name"};
+            }
+            return id;
+        }
+        checkName(name);
+        return insert(ComponentInfo::of<Component>(std::move(name)));
+    }
+
+    /**
+     * Register a type defined at run time, and return the new ID it gets;
+     * the ID and pool factory of the info are ignored. Throws
+     * std::invalid_argument if the name is already registered, the size is
+     * zero, or the alignment is not a power of two dividing the size.
+     */
+    ComponentId add(ComponentInfo info)
+    {
+        if (info.size == 0 || !std::has_single_bit(info.alignment) ||
+                info.size % info.alignment != 0) {
+            throw std::invalid_argument{
+                "ge::thing::ComponentRegistry::add: bad layout"};
+        }
+        std::unique_lock lock{_mutex};
+        checkName(info.name);
+        info.id = internals::nextComponentId();
+        info.createPool = nullptr;
+        return insert(std::move(info));
+    }
+
+    const ComponentInfo* find(ComponentId id) const
+    {
+        std::shared_lock lock{_mutex};
+        return findLocked(id);
+    }
+
+    const ComponentInfo* find(std::string_view name) const
+    {
+        std::shared_lock lock{_mutex};
+        auto it = _names.find(name);
+        return it == _names.end() ? nullptr : _infos[it->second].get();
+    }
+
+    /**
+     * Throws std::out_of_range if the ID is not registered.
+     */
+    const ComponentInfo& at(ComponentId id) const
+    {
+        auto info = find(id);
+        if (!info) {
+            throw std::out_of_range{"ge::thing::ComponentRegistry::at"};
+        }
+        return *info;
+    }
+
+private:
+    const ComponentInfo* findLocked(ComponentId id) const
+    {
+        return id < _infos.size() ? _infos[id].get() : nullptr;
+    }
+
+    void checkName(const std::string& name) const
+    {
+        if (_names.contains(name)) {
+            throw std::invalid_argument{
+                "ge::thing::ComponentRegistry::add: name is taken"};
+        }
+    }
+
+    ComponentId insert(ComponentInfo info)
+    {
+        auto id = info.id;
+        if (id >= _infos.size()) {
+            _infos.resize(id + 1);
+        }
+        _names.emplace(info.name, id);
+        _infos[id] = std::make_unique<ComponentInfo>(std::move(info));
+        return id;
+    }
+
+    mutable std::shared_mutex _mutex;
+    // Infos by ID; null for IDs that are not registered.
+    std::vector<std::unique_ptr<const ComponentInfo>> _infos;
+    std::map<std::string, ComponentId, std::less<>> _names;
+};
+
+/**
+ * The registry of the program, used by the entity manager to create the
+ * pools of components added by ID.
+ */
+inline ComponentRegistry& componentRegistry()
+{
+    static ComponentRegistry registry;
+    return registry;
+}
+
+} // namespace ge::thing
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <thing/command_buffer.hpp>
+#include <thing/component_id.hpp>
+#include <thing/entity_manager.hpp>
+#include <thing/thread_pool.hpp>
+#include <thing/view.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+/**
+ * Access of a system that makes structural changes (creates or kills
+ * entities, adds or removes components) directly, instead of through its
+ * command buffer. Such a system never runs concurrently with any other.
+ */
+struct Exclusive {};
+
+namespace internals {
+
+struct SystemAccess {
+    std::vector<ComponentId> reads;
+    std::vector<ComponentId> writes;
+    bool exclusive = false;
+
+    template <class Component>
+    void add(Read<Component>)
+    {
+        reads.push_back(componentId<Component>());
+    }
+
+    template <class Component>
+    void add(Write<Component>)
+    {
+        writes.push_back(componentId<Component>());
+    }
+
+    void add(Exclusive)
+    {
+        exclusive = true;
+    }
+
+    bool conflicts(const SystemAccess& other) const
+    {
+        return exclusive || other.exclusive ||
+            intersect(writes, other.writes) ||
+            intersect(writes, other.reads) ||
+            intersect(reads, other.writes);
+    }
+
+    static bool intersect(
+        const std::vector<ComponentId>& lhs,
+        const std::vector<ComponentId>& rhs)
+    {
+        return std::any_of(lhs.begin(), lhs.end(), [&rhs] (const auto& type) {
+            return std::find(rhs.begin(), rhs.end(), type) != rhs.end();
+        });
+    }
+};
+
+using SystemFunction = std::function<void(EntityManager&, CommandBuffer&)>;
+
+template <class Access>
+inline constexpr bool isRead = false;
+
+template <class Component>
+inline constexpr bool isRead<Read<Component>> = true;
+
+template <class Access>
+inline constexpr bool isExclusive = std::is_same_v<Access, Exclusive>;
+
+template <class Component, class... Access>
+inline constexpr bool writes =
+    (std::is_same_v<Access, Write<Component>> || ...);
+
+// The component, or the view term, const unless it is written.
+template <class Component, class... Access>
+using AccessedComponent = std::conditional_t<
+    writes<Component, Access...>, Component, const Component>;
+
+template <class Term, class... Access>
+using AccessedTerm = std::conditional_t<
+    writes<std::remove_const_t<TermComponent<Term>>, Access...>,
+    Term,
+    ConstTermOf<Term>>;
+
+} // namespace internals
+
+/**
+ * The entity manager as given to a system that writes components without
+ * being Exclusive. The components it declares as Write are mutable, and
+ * all others are const, so that reading a component never marks it as
+ * changed while other systems read it at the same time. Views turn the
+ * terms of other components const. Everything else can be read through
+ * manager().
+ */
+template <class... Access>
+class SystemManager {
+public:
+    explicit SystemManager(EntityManager& manager)
+        : _manager(manager)
+    { }
+
+    const EntityManager& manager() const
+    {
+        return _manager;
+    }
+
+    bool alive(Entity entity) const
+    {
+        return _manager.alive(entity);
+    }
+
+    Tick tick() const
+    {
+        return _manager.tick();
+    }
+
+    template <class Component>
+    bool has(Entity entity) const
+    {
+        return _manager.has<Component>(entity);
+    }
+
+    /**
+     * Mutable for a written component, which marks it as changed at the
+     * current tick.
+     */
+    template <class Component>
+    internals::ReferenceFor<
+        internals::AccessedComponent<Component, Access...>>
+    component(Entity entity)
+    {
+        return managerFor<Component>().template component<Component>(
+            entity);
+    }
+
+    template <class Component>
+    std::span<internals::AccessedComponent<Component, Access...>>
+    components()
+    {
+        return managerFor<Component>().template components<Component>();
+    }
+
+    template <class Component>
+    std::span<const Entity> entities() const
+    {
+        return _manager.entities<Component>();
+    }
+
+    template <class Component>
+        requires internals::writes<Component, Access...>
+    void markChanged(Entity entity)
+    {
+        _manager.markChanged<Component>(entity);
+    }
+
+    template <class... Terms>
+    View<internals::AccessedTerm<Terms, Access...>...> view(Tick since = 0)
+    {
+        return _manager.view<internals::AccessedTerm<Terms, Access...>...>(
+            since);
+    }
+
+    template <class... Components, class Function>
+    void parallelEach(ThreadPool& pool, Function&& function)
+    {
+        view<Components...>().parallelEach(
+            pool, std::forward<Function>(function));
+    }
+
+private:
+    template <class Component>
+    auto& managerFor()
+    {
+        if constexpr (internals::writes<Component, Access...>) {
+            return _manager;
+        } else {
+            return std::as_const(_manager);
+        }
+    }
+
+    EntityManager& _manager;
+};
+
+/**
+ * A system together with the declaration of the components it accesses, e.g.
+ * System<Read<Position>, Write<Velocity>>. The system must not touch any
+ * other components.
+ *
+ * The function takes either (Manager&), or (Manager&, CommandBuffer&). In
+ * the latter case, the system may record structural changes into the
+ * command buffer; those are applied when all systems of the run have
+ * finished. Since systems that read the same components run concurrently,
+ * and mutable access marks components as changed, only Exclusive systems
+ * get a mutable EntityManager. A system that only declares Read accesses
+ * gets a const EntityManager, and any other one a SystemManager.
+ */
+template <class... Access>
+class System {
+public:
+    static constexpr bool readOnly = (internals::isRead<Access> && ...);
+    static constexpr bool exclusive =
+        (internals::isExclusive<Access> || ...);
+
+    using Manager = std::conditional_t<
+        readOnly,
+        const EntityManager,
+        std::conditional_t<
+            exclusive, EntityManager, SystemManager<Access...>>>;
+
+    template <class Function>
+        requires std::invocable<Function&, Manager&, CommandBuffer&>
+    explicit System(Function&& function)
+        : _function(
+            [function = std::forward<Function>(function)] (
+                    EntityManager& manager, CommandBuffer& commands) mutable {
+                auto&& systemManager = adapt(manager);
+                function(systemManager, commands);
+            })
+    { }
+
+    template <class Function>
+        requires std::invocable<Function&, Manager&>
+    explicit System(Function&& function)
+        : _function(
+            [function = std::forward<Function>(function)] (
+                    EntityManager& manager, CommandBuffer&) mutable {
+                auto&& systemManager = adapt(manager);
+                function(systemManager);
+            })
+    { }
+
+    static internals::SystemAccess access()
+    {
+        internals::SystemAccess access;
+        (access.add(Access{}), ...);
+        return access;
+    }
+
+    internals::SystemFunction& function()
+    {
+        return _function;
+    }
+
+private:
+    static decltype(auto) adapt(EntityManager& manager)
+    {
+        if constexpr (std::is_same_v<Manager, SystemManager<Access...>>) {
+            return SystemManager<Access...>{manager};
+        } else {
+            return static_cast<Manager&>(manager);
+        }
+    }
+
+    internals::SystemFunction _function;
+};
+
+/**
+ * Runs systems over an entity manager. Systems are ordered by the order in
+ * which they were added, but only where their declared accesses conflict:
+ * two systems conflict if either of them writes a component that the other
+ * one reads or writes. Systems that do not conflict run concurrently.
+ */
+class Scheduler {
+public:
+    template <class... Access, class Function>
+    void add(Function&& function)
+    {
+        add(System<Access...>{std::forward<Function>(function)});
+    }
+
+    template <class... Access>
+    void add(System<Access...> system)
+    {
+        auto node = Node{
+            std::move(system.function()),
+            System<Access...>::access()};
+        for (size_t i = 0; i < _nodes.size(); i++) {
+            if (_nodes[i].access.conflicts(node.access)) {
+                _nodes[i].dependents.push_back(_nodes.size());
+                ++node.dependencyCount;
+            }
+        }
+        _nodes.push_back(std::move(node));
+    }
+
+    size_t size() const
+    {
+        return _nodes.size();
+    }
+
+    /**
+     * Run all systems on the calling thread, in the order they were added.
+     */
+    void run(EntityManager& manager) const
+    {
+        CommandBuffer commands{manager};
+        for (const auto& node : _nodes) {
+            node.function(manager, commands);
+        }
+        commands.apply();
+    }
+
+    /**
+     * Run all systems on the thread pool, and wait for them to finish. Every
+     * system records into its own command buffer, and the buffers are
+     * applied in the order the systems were added. If a system throws,
+     * systems that depend on it are not run, and the exception is rethrown
+     * once the rest have finished; no commands are applied in that case.
+     */
+    void run(EntityManager& manager, ThreadPool& pool) const
+    {
+        auto remaining =
+            std::make_unique<std::atomic<size_t>[]>(_nodes.size());
+        std::vector<CommandBuffer> commands;
+        commands.reserve(_nodes.size());
+        for (size_t i = 0; i < _nodes.size(); i++) {
+            remaining[i] = _nodes[i].dependencyCount;
+            commands.emplace_back(manager);
+        }
+
+        TaskGroup group{pool};
+        std::function<void(size_t)> launch = [&] (size_t index) {
+            group.run([&, index] {
+                const auto& node = _nodes[index];
+                node.function(manager, commands[index]);
+                for (auto dependent : node.dependents) {
+                    if (--remaining[dependent] == 0) {
+                        launch(dependent);
+                    }
+                }
+            });
+        };
+
+        for (size_t i = 0; i < _nodes.size(); i++) {
+            if (_nodes[i].dependencyCount == 0) {
+                launch(i);
+            }
+        }
+        group.wait();
+
+        CommandBuffer merged{manager};
+        for (auto& buffer : commands) {
+            merged.append(std::move(buffer));
+        }
+        merged.apply();
+    }
+
+private:
+    struct Node {
+        internals::SystemFunction function;
+        internals::SystemAccess access;
+        std::vector<size_t> dependents {};
+        size_t dependencyCount = 0;
+    };
+
+    std::vector<Node> _nodes;
+};
+
+} // namespace ge::thing
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <thing/component_id.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace ge::thing {
+
+/**
+ * Memory use of one component pool. Byte counts are what the pool has
+ * allocated, whether in use or not.
+ */
+struct PoolStatistics {
+    ComponentId component = 0;
+    // Number of components in the pool.
+    size_t size = 0;
+    // Number of components the pool can hold without allocating.
+    size_t capacity = 0;
+    // Bytes allocated for component data.
+    size_t componentBytes = 0;
+    // Bytes allocated for everything else: the dense entity array, change
+    // ticks, and the sparse index.
+    size_t indexBytes = 0;
+    // Share of the allocated bytes that hold no live data, from 0 to 1.
+    double fragmentation = 0;
+
+    size_t totalBytes() const
+    {
+        return componentBytes + indexBytes;
+    }
+};
+
+struct MemoryStatistics {
+    size_t entitySlots = 0;
+    size_t liveEntities = 0;
+    size_t entityBytes = 0;
+    std::vector<PoolStatistics> pools;
+
+    size_t totalBytes() const
+    {
+        auto total = entityBytes;
+        for (const auto& pool : pools) {
+            total += pool.totalBytes();
+        }
+        return total;
+    }
+};
+
+} // namespace ge::thing
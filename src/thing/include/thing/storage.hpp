@@ -0,0 +1,810 @@
+#pragma once
+
+#include <thing/blob.hpp>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+/**
+ * Storage policies for component pools. The policy of a component type is
+ * taken from StorageTraits.
+ */
+namespace storage {
+
+// Components in one contiguous array, in the dense order of the pool.
+struct Dense {};
+
+// Components in fixed-size pages. A component never moves in memory while
+// it exists, but the pool offers no contiguous span.
+struct Paged {};
+
+// Membership only, with no component data. The default for empty types.
+// Each tagged entity still costs its handle, its added tick and its sparse
+// index entry in the pool, but no changed tick, since a tag cannot change.
+struct Tag {};
+
+// At most one entity has the component. No sparse index is kept.
+struct Singleton {};
+
+// One array per field, for arithmetic kernels that touch a few fields of
+// many components. The fields are listed by ColumnTraits. Components are
+// accessed through proxy references.
+struct Columns {};
+
+} // namespace storage
+
+/**
+ * Selects the storage policy for a component type: Component::Storage if
+ * the component declares one, storage::Tag for empty types, and
+ * storage::Dense otherwise. May be specialized for types that cannot
+ * declare a member.
+ */
+template <class Component>
+struct StorageTraits {
+    using Policy = storage::Dense;
+};
+
+template <class Component>
+    requires requires { typename Component::Storage; }
+struct StorageTraits<Component> {
+    using Policy = typename Component::Storage;
+};
+
+template <class Component>
+    requires (std::is_empty_v<Component> &&
+        !requires { typename Component::Storage; })
+struct StorageTraits<Component> {
+    using Policy = storage::Tag;
+};
+
+template <class Component>
+using StoragePolicy = typename StorageTraits<Component>::Policy;
+
+/**
+ * The fields of a component with storage::Columns policy: a tuple of
+ * pointers to all of its data members, taken from Component::fields, e.g.
+ *
+ *     static constexpr auto fields = std::tuple{&Particle::x, &Particle::y};
+ *
+ * May be specialized for types that cannot declare a member.
+ */
+template <class Component>
+struct ColumnTraits {
+    static constexpr auto fields = Component::fields;
+};
+
+namespace internals {
+
+/**
+ * Hint that the memory at the address is about to be read. Does nothing
+ * where the compiler has no prefetch builtin.
+ */
+inline void prefetch([[maybe_unused]] const void* address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#endif
+}
+
+/**
+ * Component payloads, addressed by the dense index of their entity in the
+ * pool. Removal swaps the last element into the removed position, as the
+ * dense entity array does.
+ */
+template <class Component>
+class DenseStorage {
+public:
+    static constexpr bool contiguous = true;
+
+    using Reference = Component&;
+    using ConstReference = const Component&;
+
+    explicit DenseStorage(
+            std::pmr::memory_resource* resource =
+                std::pmr::get_default_resource())
+        : _values(resource)
+    { }
+
+    size_t size() const
+    {
+        return _values.size();
+    }
+
+    size_t capacity() const
+    {
+        return _values.capacity();
+    }
+
+    // Bytes allocated for components.
+    size_t memory() const
+    {
+        return _values.capacity() * sizeof(Component);
+    }
+
+    void reserve(size_t capacity)
+    {
+        _values.reserve(capacity);
+    }
+
+    void prefetch(size_t index) const
+    {
+        internals::prefetch(&_values[index]);
+    }
+
+    const Component& operator[](size_t index) const
+    {
+        return _values[index];
+    }
+
+    Component& operator[](size_t index)
+    {
+        return _values[index];
+    }
+
+    std::span<const Component> span() const
+    {
+        return _values;
+    }
+
+    std::span<Component> span()
+    {
+        return _values;
+    }
+
+    template <class... Args>
+    Component& emplace(Args&&... args)
+    {
+        return _values.emplace_back(std::forward<Args>(args)...);
+    }
+
+    void swapRemove(size_t index)
+    {
+        if (index != _values.size() - 1) {
+            _values[index] = std::move(_values.back());
+        }
+        _values.pop_back();
+    }
+
+    void swap(size_t lhs, size_t rhs)
+    {
+        using std::swap;
+        swap(_values[lhs], _values[rhs]);
+    }
+
+    void shrinkToFit()
+    {
+        _values.shrink_to_fit();
+    }
+
+    /**
+     * Replace the contents with copies of the other storage's components,
+     * in the same order. Trivially copyable components are copied as one
+     * block.
+     */
+    void assign(const DenseStorage& other)
+    {
+        _values.assign(other._values.begin(), other._values.end());
+    }
+
+    void save(BlobWriter& writer) const
+    {
+        writer.writeArray<Component>(_values);
+    }
+
+    void load(BlobReader& reader)
+    {
+        reader.readArray(_values);
+    }
+
+private:
+    std::pmr::vector<Component> _values;
+};
+
+template <class Component>
+class PagedStorage {
+public:
+    static constexpr bool contiguous = false;
+
+    using Reference = Component&;
+    using ConstReference = const Component&;
+
+    explicit PagedStorage(
+            std::pmr::memory_resource* resource =
+                std::pmr::get_default_resource())
+        : _pages(resource)
+        , _slots(resource)
+        , _freeSlots(resource)
+    { }
+
+    PagedStorage(const PagedStorage&) = delete;
+    PagedStorage& operator=(const PagedStorage&) = delete;
+
+    PagedStorage(PagedStorage&& other) noexcept
+        : _pages(std::move(other._pages))
+        , _slots(std::move(other._slots))
+        , _freeSlots(std::move(other._freeSlots))
+    {
+        other._pages.clear();
+        other._slots.clear();
+    }
+
+    // Pages come from the memory resource of the storage, which cannot be
+    // replaced by assignment.
+    PagedStorage& operator=(PagedStorage&&) = delete;
+
+    ~PagedStorage()
+    {
+        clear();
+        for (auto page : _pages) {
+            allocator().deallocate(page, 1);
+        }
+    }
+
+    size_t size() const
+    {
+        return _slots.size();
+    }
+
+    size_t capacity() const
+    {
+        return _pages.size() * PageSize;
+    }
+
+    // Bytes allocated for pages, and for the dense and free slot arrays.
+    size_t memory() const
+    {
+        return _pages.size() * sizeof(Page) +
+            (_slots.capacity() + _freeSlots.capacity()) * sizeof(size_t) +
+            _pages.capacity() * sizeof(Page*);
+    }
+
+    void reserve(size_t capacity)
+    {
+        _slots.reserve(capacity);
+    }
+
+    void prefetch(size_t index) const
+    {
+        internals::prefetch(slot(_slots[index]));
+    }
+
+    const Component& operator[](size_t index) const
+    {
+        return *slot(_slots[index]);
+    }
+
+    Component& operator[](size_t index)
+    {
+        return *slot(_slots[index]);
+    }
+
+    template <class... Args>
+    Component& emplace(Args&&... args)
+    {
+        auto index = allocate();
+        Component* component = nullptr;
+        try {
+            component = new (slot(index)) Component(
+                std::forward<Args>(args)...);
+        } catch (...) {
+            _freeSlots.push_back(index);
+            throw;
+        }
+        _slots.push_back(index);
+        return *component;
+    }
+
+    void swapRemove(size_t index)
+    {
+        slot(_slots[index])->~Component();
+        _freeSlots.push_back(_slots[index]);
+        _slots[index] = _slots.back();
+        _slots.pop_back();
+    }
+
+    // Components stay where they are; only the dense order changes.
+    void swap(size_t lhs, size_t rhs)
+    {
+        std::swap(_slots[lhs], _slots[rhs]);
+    }
+
+    // Pages are addressed by position, so only the slot arrays shrink.
+    void shrinkToFit()
+    {
+        _slots.shrink_to_fit();
+        _freeSlots.shrink_to_fit();
+    }
+
+    void assign(const PagedStorage& other)
+    {
+        clear();
+        reserve(other.size());
+        for (size_t i = 0; i < other.size(); i++) {
+            emplace(other[i]);
+        }
+    }
+
+    void save(BlobWriter& writer) const
+    {
+        writer.write<uint64_t>(_slots.size());
+        for (auto index : _slots) {
+            writer.write(*slot(index));
+        }
+    }
+
+    void load(BlobReader& reader)
+    {
+        clear();
+        auto size = reader.readArraySize(sizeof(Component));
+        reserve(size);
+        for (size_t i = 0; i < size; i++) {
+            emplace(reader.read<Component>());
+        }
+    }
+
+private:
+    static constexpr size_t PageSize =
+        std::max<size_t>(1, 16 * 1024 / sizeof(Component));
+
+    struct Page {
+        alignas(Component) std::byte data[sizeof(Component) * PageSize];
+    };
+
+    Component* slot(size_t index) const
+    {
+        return std::launder(reinterpret_cast<Component*>(
+            _pages[index / PageSize]->data) + index % PageSize);
+    }
+
+    size_t allocate()
+    {
+        if (_freeSlots.empty()) {
+            auto first = _pages.size() * PageSize;
+            auto page = allocator().allocate(1);
+            try {
+                _pages.push_back(page);
+            } catch (...) {
+                allocator().deallocate(page, 1);
+                throw;
+            }
+            for (size_t i = PageSize; i > 0; i--) {
+                _freeSlots.push_back(first + i - 1);
+            }
+        }
+        auto index = _freeSlots.back();
+        _freeSlots.pop_back();
+        return index;
+    }
+
+    void clear()
+    {
+        for (auto index : _slots) {
+            slot(index)->~Component();
+        }
+        _slots.clear();
+    }
+
+    std::pmr::polymorphic_allocator<Page> allocator() const
+    {
+        return std::pmr::polymorphic_allocator<Page>{
+            _pages.get_allocator().resource()};
+    }
+
+    std::pmr::vector<Page*> _pages;
+    std::pmr::vector<size_t> _slots;
+    std::pmr::vector<size_t> _freeSlots;
+};
+
+template <class Component>
+class TagStorage {
+public:
+    static constexpr bool contiguous = false;
+
+    using Reference = Component&;
+    using ConstReference = const Component&;
+
+    explicit TagStorage(std::pmr::memory_resource* = nullptr) {}
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    size_t capacity() const
+    {
+        return _size;
+    }
+
+    size_t memory() const
+    {
+        return 0;
+    }
+
+    void reserve(size_t) {}
+
+    void prefetch(size_t) const {}
+
+    Component& operator[](size_t) const
+    {
+        return _instance;
+    }
+
+    template <class... Args>
+    Component& emplace(Args&&...)
+    {
+        ++_size;
+        return _instance;
+    }
+
+    void swapRemove(size_t)
+    {
+        --_size;
+    }
+
+    void swap(size_t, size_t) {}
+
+    void shrinkToFit() {}
+
+    void assign(const TagStorage& other)
+    {
+        _size = other._size;
+    }
+
+    void save(BlobWriter& writer) const
+    {
+        writer.write<uint64_t>(_size);
+    }
+
+    void load(BlobReader& reader)
+    {
+        _size = static_cast<size_t>(reader.read<uint64_t>());
+    }
+
+private:
+    // All tags are the same empty object.
+    static inline Component _instance {};
+
+    size_t _size = 0;
+};
+
+template <class Pointer>
+struct MemberPointer;
+
+template <class Class, class Value>
+struct MemberPointer<Value Class::*> {
+    using Owner = Class;
+    using Type = Value;
+};
+
+template <class Component, bool Const>
+class ColumnReference;
+
+/**
+ * Components decomposed into one array per field. A component is rebuilt
+ * from its fields when it is read by value, so every data member must be
+ * listed in ColumnTraits, and the component must be default-constructible.
+ */
+template <class Component>
+class ColumnStorage {
+    static constexpr auto fields = ColumnTraits<Component>::fields;
+
+    using Fields = std::remove_const_t<decltype(fields)>;
+    static constexpr size_t fieldCount = std::tuple_size_v<Fields>;
+
+    template <size_t I>
+    using FieldType = typename MemberPointer<
+        std::tuple_element_t<I, Fields>>::Type;
+
+    template <class Sequence>
+    struct ColumnsOf;
+
+    template <size_t... I>
+    struct ColumnsOf<std::index_sequence<I...>> {
+        using Type = std::tuple<std::pmr::vector<FieldType<I>>...>;
+    };
+
+    using Columns =
+        typename ColumnsOf<std::make_index_sequence<fieldCount>>::Type;
+
+    static_assert(fieldCount > 0, "a columnar component needs fields");
+    static_assert(std::default_initializable<Component>);
+
+public:
+    static constexpr bool contiguous = false;
+
+    using Reference = ColumnReference<Component, false>;
+    using ConstReference = ColumnReference<Component, true>;
+
+    explicit ColumnStorage(
+            std::pmr::memory_resource* resource =
+                std::pmr::get_default_resource())
+        : ColumnStorage(resource, std::make_index_sequence<fieldCount>{})
+    { }
+
+    size_t size() const
+    {
+        return std::get<0>(_columns).size();
+    }
+
+    size_t capacity() const
+    {
+        return std::get<0>(_columns).capacity();
+    }
+
+    size_t memory() const
+    {
+        return std::apply([] (const auto&... columns) {
+            return (... + (columns.capacity() * sizeof(columns[0])));
+        }, _columns);
+    }
+
+    void reserve(size_t capacity)
+    {
+        std::apply([capacity] (auto&... columns) {
+            (columns.reserve(capacity), ...);
+        }, _columns);
+    }
+
+    void prefetch(size_t index) const
+    {
+        std::apply([index] (const auto&... columns) {
+            (internals::prefetch(&columns[index]), ...);
+        }, _columns);
+    }
+
+    ConstReference operator[](size_t index) const
+    {
+        return ConstReference{*this, index};
+    }
+
+    Reference operator[](size_t index)
+    {
+        return Reference{*this, index};
+    }
+
+    /**
+     * The column of a field, e.g. column<&Particle::x>().
+     */
+    template <auto Field>
+    std::span<const typename MemberPointer<decltype(Field)>::Type>
+    column() const
+    {
+        return std::get<columnIndex<Field>()>(_columns);
+    }
+
+    template <auto Field>
+    std::span<typename MemberPointer<decltype(Field)>::Type> column()
+    {
+        return std::get<columnIndex<Field>()>(_columns);
+    }
+
+    template <class... Args>
+    Reference emplace(Args&&... args)
+    {
+        Component component{std::forward<Args>(args)...};
+        // Grow all columns up front, so that they stay the same size.
+        if (size() == capacity()) {
+            reserve(std::max<size_t>(8, 2 * size()));
+        }
+        [&] <size_t... I> (std::index_sequence<I...>) {
+            (std::get<I>(_columns).push_back(
+                component.*std::get<I>(fields)), ...);
+        }(std::make_index_sequence<fieldCount>{});
+        return Reference{*this, size() - 1};
+    }
+
+    void swapRemove(size_t index)
+    {
+        std::apply([index] (auto&... columns) {
+            ((index != columns.size() - 1 ?
+                (void)(columns[index] = std::move(columns.back())) :
+                (void)0,
+                columns.pop_back()), ...);
+        }, _columns);
+    }
+
+    void swap(size_t lhs, size_t rhs)
+    {
+        std::apply([lhs, rhs] (auto&... columns) {
+            using std::swap;
+            (swap(columns[lhs], columns[rhs]), ...);
+        }, _columns);
+    }
+
+    void shrinkToFit()
+    {
+        std::apply([] (auto&... columns) {
+            (columns.shrink_to_fit(), ...);
+        }, _columns);
+    }
+
+    void assign(const ColumnStorage& other)
+    {
+        [&] <size_t... I> (std::index_sequence<I...>) {
+            (std::get<I>(_columns).assign(
+                std::get<I>(other._columns).begin(),
+                std::get<I>(other._columns).end()), ...);
+        }(std::make_index_sequence<fieldCount>{});
+    }
+
+    void save(BlobWriter& writer) const
+    {
+        std::apply([&writer] (const auto&... columns) {
+            (writer.writeArray<typename std::decay_t<
+                decltype(columns)>::value_type>(columns), ...);
+        }, _columns);
+    }
+
+    void load(BlobReader& reader)
+    {
+        std::apply([&reader] (auto&... columns) {
+            (reader.readArray(columns), ...);
+        }, _columns);
+        auto size = this->size();
+        std::apply([size] (const auto&... columns) {
+            if ((... || (columns.size() != size))) {
+                throw std::runtime_error{
+                    "ge::thing::internals::ColumnStorage::load: "
+                    "inconsistent columns"};
+            }
+        }, _columns);
+    }
+
+    Component get(size_t index) const
+    {
+        Component component{};
+        [&] <size_t... I> (std::index_sequence<I...>) {
+            ((component.*std::get<I>(fields) =
+                std::get<I>(_columns)[index]), ...);
+        }(std::make_index_sequence<fieldCount>{});
+        return component;
+    }
+
+    void set(size_t index, const Component& component)
+    {
+        [&] <size_t... I> (std::index_sequence<I...>) {
+            ((std::get<I>(_columns)[index] =
+                component.*std::get<I>(fields)), ...);
+        }(std::make_index_sequence<fieldCount>{});
+    }
+
+private:
+    template <size_t... I>
+    ColumnStorage(
+            std::pmr::memory_resource* resource, std::index_sequence<I...>)
+        : _columns(std::tuple_element_t<I, Columns>(resource)...)
+    { }
+
+    template <auto Field>
+    static constexpr size_t columnIndex()
+    {
+        using Pointer = decltype(Field);
+        static_assert(
+            std::is_same_v<
+                typename MemberPointer<Pointer>::Owner, Component>,
+            "the field belongs to another component");
+        constexpr auto index = [] <size_t... I> (std::index_sequence<I...>) {
+            size_t index = fieldCount;
+            ((index == fieldCount && sameField<Field>(std::get<I>(fields)) ?
+                (void)(index = I) : (void)0), ...);
+            return index;
+        }(std::make_index_sequence<fieldCount>{});
+        static_assert(index < fieldCount, "the field is not a column");
+        return index;
+    }
+
+    template <auto Field, class Pointer>
+    static constexpr bool sameField(Pointer pointer)
+    {
+        if constexpr (std::is_same_v<Pointer, decltype(Field)>) {
+            return pointer == Field;
+        } else {
+            return false;
+        }
+    }
+
+    Columns _columns;
+};
+
+/**
+ * Proxy reference to a component in columnar storage. Reads and assigns
+ * whole components by value, or single fields with get().
+ */
+template <class Component, bool Const>
+class ColumnReference {
+    using Storage = std::conditional_t<
+        Const, const ColumnStorage<Component>, ColumnStorage<Component>>;
+
+public:
+    ColumnReference(Storage& storage, size_t index)
+        : _storage(&storage)
+        , _index(index)
+    { }
+
+    ColumnReference(const ColumnReference&) = default;
+
+    // A mutable reference converts to a const one.
+    operator ColumnReference<Component, true>() const requires (!Const)
+    {
+        return {*_storage, _index};
+    }
+
+    /**
+     * A field of the component, e.g. get<&Particle::x>().
+     */
+    template <auto Field>
+    auto& get() const
+    {
+        return _storage->template column<Field>()[_index];
+    }
+
+    operator Component() const
+    {
+        return _storage->get(_index);
+    }
+
+    // Assignment writes through, as for a plain reference.
+    const ColumnReference& operator=(const Component& component) const
+        requires (!Const)
+    {
+        _storage->set(_index, component);
+        return *this;
+    }
+
+    const ColumnReference& operator=(const ColumnReference& other) const
+        requires (!Const)
+    {
+        return *this = Component(other);
+    }
+
+private:
+    Storage* _storage;
+    size_t _index;
+};
+
+template <class Component, class Policy = StoragePolicy<Component>>
+struct StorageFor;
+
+template <class Component>
+struct StorageFor<Component, storage::Dense> {
+    using Type = DenseStorage<Component>;
+};
+
+template <class Component>
+struct StorageFor<Component, storage::Singleton> {
+    using Type = DenseStorage<Component>;
+};
+
+template <class Component>
+struct StorageFor<Component, storage::Paged> {
+    using Type = PagedStorage<Component>;
+};
+
+template <class Component>
+struct StorageFor<Component, storage::Columns> {
+    using Type = ColumnStorage<Component>;
+};
+
+template <class Component>
+struct StorageFor<Component, storage::Tag> {
+    static_assert(
+        std::is_empty_v<Component>, "only empty types can be stored as tags");
+    using Type = TagStorage<Component>;
+};
+
+} // namespace internals
+
+} // namespace ge::thing
@@ -0,0 +1,44 @@
+#pragma once
+
+namespace ge::thing {
+
+/**
+ * View terms for the access to a component. A bare component type is
+ * written, as with Write<>, and yields Component&; with EntityManager, it
+ * marks every entry it visits as changed at the current tick. Read<>, like
+ * a const component type, yields const Component& and marks nothing, so
+ * code that only reads should use it, or Changed<> filters see every entry
+ * as changed. Systems declare their accesses with the same terms.
+ */
+template <class Component>
+struct Read {};
+
+template <class Component>
+struct Write {};
+
+namespace internals {
+
+/**
+ * The component of an access term, const if it is only read.
+ */
+template <class Term>
+struct TermAccess {
+    using Component = Term;
+};
+
+template <class Term>
+struct TermAccess<Read<Term>> {
+    using Component = const Term;
+};
+
+template <class Term>
+struct TermAccess<Write<Term>> {
+    using Component = Term;
+};
+
+template <class Term>
+using AccessType = typename TermAccess<Term>::Component;
+
+} // namespace internals
+
+} // namespace ge::thing
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ge::thing {
+
+/**
+ * Work-stealing thread pool. Every worker has its own task queue; it takes
+ * tasks from the back of its own queue, and steals from the front of the
+ * others' when it runs out.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(
+            size_t threadCount = std::max(
+                1u, std::thread::hardware_concurrency()))
+    {
+        for (size_t i = 0; i < std::max<size_t>(threadCount, 1); i++) {
+            _queues.push_back(std::make_unique<Queue>());
+        }
+        for (size_t i = 0; i < threadCount; i++) {
+            _threads.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock{_mutex};
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    size_t threadCount() const
+    {
+        return _threads.size();
+    }
+
+    static constexpr size_t NoWorker = static_cast<size_t>(-1);
+
+    /**
+     * A pool worker thread: its pool, and its index there.
+     */
+    struct Worker {
+        const ThreadPool* pool = nullptr;
+        size_t index = NoWorker;
+    };
+
+    /**
+     * The worker running on the calling thread. The pool is null if the
+     * thread is not a worker of any pool.
+     */
+    static Worker currentWorker()
+    {
+        return worker();
+    }
+
+    /**
+     * Pools are numbered from 0 in the order they are made.
+     */
+    size_t id() const
+    {
+        return _id;
+    }
+
+    void submit(std::function<void()> task)
+    {
+        auto index = ownWorker() == NoWorker ?
+            _nextQueue++ % _queues.size() : ownWorker();
+        {
+            std::lock_guard lock{_mutex};
+            ++_pending;
+        }
+        {
+            std::lock_guard lock{_queues[index]->mutex};
+            _queues[index]->tasks.push_back(std::move(task));
+        }
+        _wake.notify_one();
+    }
+
+    /**
+     * Run one queued task on the calling thread, if there is one. Threads
+     * waiting for their tasks to finish use this to help instead of
+     * blocking.
+     */
+    bool runPendingTask()
+    {
+        auto index = ownWorker() == NoWorker ? 0 : ownWorker();
+        std::function<void()> task;
+        if (!pop(index, task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    static Worker& worker()
+    {
+        thread_local Worker worker;
+        return worker;
+    }
+
+    static size_t nextId()
+    {
+        static std::atomic<size_t> id = 0;
+        return id++;
+    }
+
+    // Index of the calling thread among the workers of this pool. Workers
+    // of other pools are foreign to it, like any other thread.
+    size_t ownWorker() const
+    {
+        auto current = worker();
+        return current.pool == this ? current.index : NoWorker;
+    }
+
+    bool pop(size_t index, std::function<void()>& task)
+    {
+        {
+            auto& own = *_queues[index];
+            std::lock_guard lock{own.mutex};
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                taken();
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < _queues.size(); i++) {
+            auto& other = *_queues[(index + i) % _queues.size()];
+            std::lock_guard lock{other.mutex};
+            if (!other.tasks.empty()) {
+                task = std::move(other.tasks.front());
+                other.tasks.pop_front();
+                taken();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void taken()
+    {
+        std::lock_guard lock{_mutex};
+        --_pending;
+    }
+
+    void work(size_t index)
+    {
+        worker() = {this, index};
+        for (;;) {
+            std::function<void()> task;
+            if (pop(index, task)) {
+                task();
+                continue;
+            }
+
+            std::unique_lock lock{_mutex};
+            _wake.wait(lock, [this] { return _stop || _pending > 0; });
+            if (_stop && _pending == 0) {
+                return;
+            }
+        }
+    }
+
+    size_t _id = nextId();
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::atomic<size_t> _nextQueue = 0;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    size_t _pending = 0;
+    bool _stop = false;
+};
+
+/**
+ * A set of tasks submitted to a thread pool that can be waited for. The
+ * waiting thread runs queued tasks itself while it waits, so groups can be
+ * nested inside pool tasks. The first exception thrown by a task is
+ * rethrown from wait().
+ */
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool)
+        : _pool(pool)
+    { }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup(TaskGroup&&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    TaskGroup& operator=(TaskGroup&&) = delete;
+
+    ~TaskGroup()
+    {
+        waitAll();
+    }
+
+    template <class Function>
+    void run(Function&& function)
+    {
+        ++_state->running;
+        _pool.submit(
+            [state = _state,
+                function = std::forward<Function>(function)] () mutable {
+                try {
+                    function();
+                } catch (...) {
+                    std::lock_guard lock{state->mutex};
+                    if (!state->exception) {
+                        state->exception = std::current_exception();
+                    }
+                }
+                if (--state->running == 0) {
+                    state->running.notify_all();
+                }
+            });
+    }
+
+    void wait()
+    {
+        waitAll();
+        std::lock_guard lock{_state->mutex};
+        if (_state->exception) {
+            std::rethrow_exception(std::exchange(_state->exception, nullptr));
+        }
+    }
+
+private:
+    // Shared with the tasks, which may still be touching it after the
+    // waiting thread has seen the counter drop to zero.
+    struct State {
+        std::atomic<size_t> running = 0;
+        std::mutex mutex;
+        std::exception_ptr exception;
+    };
+
+    void waitAll()
+    {
+        while (auto running = _state->running.load()) {
+            if (!_pool.runPendingTask()) {
+                _state->running.wait(running);
+            }
+        }
+    }
+
+    ThreadPool& _pool;
+    std::shared_ptr<State> _state = std::make_shared<State>();
+};
+
+} // namespace ge::thing
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ge::thing {
+
+/**
+ * Logical time of the entity manager, used to stamp component changes.
+ */
+using Tick = uint64_t;
+
+namespace internals {
+
+/**
+ * Current tick of an entity manager, shared with its pools so that they can
+ * stamp changes without going through the manager.
+ */
+struct Clock {
+    std::atomic<Tick> tick = 1;
+};
+
+// Number of dense pool entries summarized by one chunk tick.
+inline constexpr size_t TickChunkSize = 256;
+
+} // namespace internals
+
+} // namespace ge::thing
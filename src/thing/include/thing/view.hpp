@@ -0,0 +1,365 @@
+#pragma once
+
+#include <thing/components.hpp>
+#include <thing/entity.hpp>
+#include <thing/term.hpp>
+#include <thing/thread_pool.hpp>
+#include <thing/tick.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ge::thing {
+
+/**
+ * View filters: only entities whose component was changed, or added, after
+ * the tick the view was created with. The filtered term is yielded as it
+ * would be without the filter.
+ */
+template <class Component>
+struct Changed {};
+
+template <class Component>
+struct Added {};
+
+namespace internals {
+
+enum class Filter {
+    None,
+    Changed,
+    Added,
+};
+
+template <class Term>
+struct ViewTerm {
+    using Component = AccessType<Term>;
+    static constexpr Filter filter = Filter::None;
+};
+
+template <class Term>
+struct ViewTerm<Changed<Term>> {
+    using Component = AccessType<Term>;
+    static constexpr Filter filter = Filter::Changed;
+};
+
+template <class Term>
+struct ViewTerm<Added<Term>> {
+    using Component = AccessType<Term>;
+    static constexpr Filter filter = Filter::Added;
+};
+
+template <class Term>
+using TermComponent = typename ViewTerm<Term>::Component;
+
+/**
+ * The same view term, with its component made const.
+ */
+template <class Term>
+struct ConstTerm {
+    using Type = const AccessType<Term>;
+};
+
+template <class Term>
+struct ConstTerm<Changed<Term>> {
+    using Type = Changed<const AccessType<Term>>;
+};
+
+template <class Term>
+struct ConstTerm<Added<Term>> {
+    using Type = Added<const AccessType<Term>>;
+};
+
+template <class Term>
+using ConstTermOf = typename ConstTerm<Term>::Type;
+
+} // namespace internals
+
+/**
+ * Iterates over entities that have all of the given components. Iteration is
+ * driven by the smallest of the pools; the rest are only probed. Yields
+ * (Entity, Components&...) tuples, with const references for const and
+ * Read<> terms.
+ *
+ * Terms may be wrapped into Changed<> or Added<> filters. The driving pool
+ * is then the smallest of the filtered ones, and whole chunks of it whose
+ * summary tick is not newer than the view's tick are skipped without
+ * looking at their entries.
+ */
+template <class... Terms>
+class View {
+    static_assert(sizeof...(Terms) > 0);
+
+    using Pools = std::tuple<
+        internals::PoolFor<internals::TermComponent<Terms>>*...>;
+    using Indices = std::array<size_t, sizeof...(Terms)>;
+
+    static constexpr bool filtered = (... ||
+        (internals::ViewTerm<Terms>::filter != internals::Filter::None));
+
+public:
+    using value_type =
+        std::tuple<
+            Entity,
+            internals::ReferenceFor<internals::TermComponent<Terms>>...>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = View::value_type;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        Iterator(const View* view, size_t position)
+            : _view(view)
+            , _position(position)
+        {
+            skip();
+        }
+
+        value_type operator*() const
+        {
+            return _view->get(
+                _view->_entities[_position],
+                _indices,
+                std::index_sequence_for<Terms...>{});
+        }
+
+        Iterator& operator++()
+        {
+            ++_position;
+            skip();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs)
+        {
+            return lhs._position == rhs._position;
+        }
+
+    private:
+        void skip()
+        {
+            auto size = _view->_entities.size();
+            while ((_position = _view->skipChunks(_position)) < size &&
+                    !_view->match(_position, _indices)) {
+                ++_position;
+            }
+        }
+
+        const View* _view = nullptr;
+        size_t _position = 0;
+        Indices _indices {};
+    };
+
+    View() = default;
+
+    explicit View(
+            internals::PoolFor<internals::TermComponent<Terms>>*... pools)
+        : View(0, pools...)
+    { }
+
+    /**
+     * With filters, only entities whose filtered components were changed or
+     * added at a tick newer than since are visited.
+     */
+    View(
+            Tick since,
+            internals::PoolFor<internals::TermComponent<Terms>>*... pools)
+        : _pools(pools...)
+        , _since(since)
+    {
+        if ((... && pools)) {
+            auto smallest = std::min({driverSize<Terms>(pools->size())...});
+            size_t index = 0;
+            ((_driver == NoDriver &&
+                driverSize<Terms>(pools->size()) == smallest ?
+                    (void)(_driver = index, _entities = pools->entities()) :
+                    (void)0,
+                ++index), ...);
+        }
+    }
+
+    Iterator begin() const
+    {
+        return Iterator{this, 0};
+    }
+
+    Iterator end() const
+    {
+        return Iterator{this, _entities.size()};
+    }
+
+    /**
+     * Upper bound for the number of entities in the view: the size of the
+     * driving pool.
+     */
+    size_t sizeHint() const
+    {
+        return _entities.size();
+    }
+
+    template <class Function>
+    void each(Function&& function) const
+    {
+        for (auto&& tuple : *this) {
+            std::apply(function, tuple);
+        }
+    }
+
+    /**
+     * Number of driving pool entries in each chunk of parallelEach(), such
+     * that a chunk covers about ChunkBytes of component data.
+     */
+    static constexpr size_t defaultChunkSize()
+    {
+        return std::max<size_t>(
+            1, ChunkBytes / (... + sizeof(internals::TermComponent<Terms>)));
+    }
+
+    /**
+     * Like each(), but runs on the thread pool. The driving pool is split
+     * into chunks of chunkSize entries. Chunk boundaries depend only on the
+     * pool contents, not on the number of threads, so every entity is
+     * always processed as part of the same chunk. The function is called
+     * concurrently, and must not make structural changes to the manager.
+     * Throws std::invalid_argument if chunkSize is 0.
+     */
+    template <class Function>
+    void parallelEach(
+        ThreadPool& pool,
+        Function&& function,
+        size_t chunkSize = defaultChunkSize()) const
+    {
+        if (chunkSize == 0) {
+            throw std::invalid_argument{
+                "ge::thing::View::parallelEach: chunk size is 0"};
+        }
+        TaskGroup group{pool};
+        for (size_t first = 0; first < _entities.size(); first += chunkSize) {
+            auto last = std::min(first + chunkSize, _entities.size());
+            group.run([this, &function, first, last] {
+                Indices indices;
+                for (size_t position = skipChunks(first); position < last;
+                        position = skipChunks(position + 1)) {
+                    if (match(position, indices)) {
+                        std::apply(
+                            function,
+                            get(
+                                _entities[position],
+                                indices,
+                                std::index_sequence_for<Terms...>{}));
+                    }
+                }
+            });
+        }
+        group.wait();
+    }
+
+private:
+    static constexpr size_t NoDriver = sizeof...(Terms);
+    static constexpr size_t ChunkBytes = 16 * 1024;
+
+    // With filters present, unfiltered pools never drive the iteration.
+    template <class Term>
+    static constexpr size_t driverSize(size_t size)
+    {
+        if (filtered &&
+                internals::ViewTerm<Term>::filter == internals::Filter::None) {
+            return static_cast<size_t>(-1);
+        }
+        return size;
+    }
+
+    /**
+     * The first position, starting from the given one, in a chunk of the
+     * driving pool that may hold entries changed after _since.
+     */
+    size_t skipChunks(size_t position) const
+    {
+        if constexpr (filtered) {
+            while (position < _entities.size()) {
+                auto chunk = position / internals::TickChunkSize;
+                if (driverChunkTick(
+                        chunk, std::index_sequence_for<Terms...>{}) > _since) {
+                    break;
+                }
+                position = (chunk + 1) * internals::TickChunkSize;
+            }
+            return std::min(position, _entities.size());
+        } else {
+            return position;
+        }
+    }
+
+    template <size_t... I>
+    Tick driverChunkTick(size_t chunk, std::index_sequence<I...>) const
+    {
+        Tick tick = 0;
+        ((I == _driver ? (void)(tick = std::get<I>(_pools)->chunkTick(chunk)) :
+            (void)0), ...);
+        return tick;
+    }
+
+    bool match(size_t position, Indices& indices) const
+    {
+        return matchPools(
+            position, indices, std::index_sequence_for<Terms...>{});
+    }
+
+    // The driving pool needs no lookup: its index is the position itself.
+    template <size_t... I>
+    bool matchPools(
+        size_t position, Indices& indices, std::index_sequence<I...>) const
+    {
+        auto entity = _entities[position];
+        return (... && (
+            (indices[I] = I == _driver ?
+                position : std::get<I>(_pools)->find(entity)) !=
+                    internals::SparseIndex::npos &&
+            passes<Terms>(*std::get<I>(_pools), indices[I])));
+    }
+
+    template <class Term, class Pool>
+    bool passes(const Pool& pool, size_t index) const
+    {
+        constexpr auto filter = internals::ViewTerm<Term>::filter;
+        if constexpr (filter == internals::Filter::Changed) {
+            return pool.changedTick(index) > _since;
+        } else if constexpr (filter == internals::Filter::Added) {
+            return pool.addedTick(index) > _since;
+        } else {
+            return true;
+        }
+    }
+
+    template <size_t... I>
+    value_type get(
+        Entity entity, const Indices& indices, std::index_sequence<I...>) const
+    {
+        return value_type{
+            entity, std::get<I>(_pools)->componentAt(indices[I])...};
+    }
+
+    Pools _pools {};
+    size_t _driver = NoDriver;
+    std::span<const Entity> _entities;
+    Tick _since = 0;
+};
+
+} // namespace ge::thing
@@ -0,0 +1,151 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <thing.hpp>
+
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Position {
+    int x;
+};
+
+struct Velocity {
+    int dx;
+};
+
+static_assert(ge::thing::EntityBackend<ge::thing::EntityManager>);
+static_assert(ge::thing::EntityBackend<ge::thing::ArchetypeEntityManager>);
+
+template <ge::thing::EntityBackend Manager>
+void requireBackend()
+{
+    Manager manager;
+    auto entities = manager.createEntities(4);
+    manager.addBatch(std::span<const ge::thing::Entity>{entities}, Velocity{7});
+    manager.template add<Position>(entities[1]).x = 1;
+    manager.killEntity(entities[0]);
+
+    REQUIRE(!manager.alive(entities[0]));
+    REQUIRE(!manager.template has<Position>(entities[0]));
+    REQUIRE(!manager.template has<Velocity>(entities[0]));
+    REQUIRE_NOTHROW(manager.template remove<Velocity>(entities[0]));
+    REQUIRE_THROWS_AS(
+        manager.template component<Velocity>(entities[0]), std::out_of_range);
+    REQUIRE_THROWS_AS(
+        manager.template component<Position>(entities[2]), std::out_of_range);
+    REQUIRE_THROWS_AS(
+        manager.template add<Position>(entities[0]), std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        manager.addBatch(std::span<const ge::thing::Entity>{entities},
+            Position{0}),
+        std::invalid_argument);
+    REQUIRE(!manager.template has<Position>(entities[2]));
+
+    int sum = 0;
+    for (auto [entity, velocity, position] :
+            manager.template view<const Velocity, const Position>()) {
+        sum += velocity.dx + position.x;
+    }
+    REQUIRE(sum == 8);
+}
+
+} // namespace
+
+TEST_CASE("Storage backends", "[archetype]")
+{
+    requireBackend<ge::thing::EntityManager>();
+    requireBackend<ge::thing::ArchetypeEntityManager>();
+}
+
+TEST_CASE("Archetype components", "[archetype]")
+{
+    ge::thing::ArchetypeEntityManager manager;
+
+    auto e1 = manager.createEntity();
+    auto e2 = manager.createEntity();
+    auto e3 = manager.createEntity();
+
+    manager.add<Position>(e1).x = 1;
+    manager.add<Position>(e2).x = 2;
+    manager.add<Velocity>(e2).dx = 20;
+    manager.add<Velocity>(e3, Velocity{30});
+    manager.add<std::string>(e3) = "three";
+
+    REQUIRE(manager.has<Position>(e1));
+    REQUIRE(!manager.has<Velocity>(e1));
+    REQUIRE(manager.component<Position>(e2).x == 2);
+    REQUIRE(manager.component<Velocity>(e2).dx == 20);
+    REQUIRE(manager.component<Velocity>(e3).dx == 30);
+    REQUIRE(manager.component<std::string>(e3) == "three");
+
+    SECTION("Remove component moves entity between archetypes")
+    {
+        manager.remove<Position>(e2);
+        REQUIRE(!manager.has<Position>(e2));
+        REQUIRE(manager.component<Velocity>(e2).dx == 20);
+        REQUIRE(manager.component<Position>(e1).x == 1);
+
+        manager.add<Position>(e2).x = 5;
+        REQUIRE(manager.component<Position>(e2).x == 5);
+        REQUIRE(manager.component<Velocity>(e2).dx == 20);
+    }
+
+    SECTION("Kill entity")
+    {
+        manager.killEntity(e1);
+        REQUIRE(!manager.alive(e1));
+        REQUIRE_THROWS_AS(
+            manager.component<Position>(e1), std::out_of_range);
+
+        manager.add<Position>(e3).x = 3;
+
+        std::vector<int> positions;
+        for (auto [entity, position] : manager.view<Position>()) {
+            positions.push_back(position.x);
+        }
+        REQUIRE(positions.size() == 2);
+        REQUIRE(manager.component<Position>(e2).x == 2);
+        REQUIRE(manager.component<Position>(e3).x == 3);
+        REQUIRE(manager.component<std::string>(e3) == "three");
+    }
+}
+
+TEST_CASE("Archetype view", "[archetype]")
+{
+    ge::thing::ArchetypeEntityManager manager;
+
+    for (int i = 0; i < 10; i++) {
+        auto entity = manager.createEntity();
+        manager.add<Position>(entity).x = i;
+        if (i % 2 == 0) {
+            manager.add<Velocity>(entity).dx = 1;
+        }
+        if (i % 3 == 0) {
+            manager.add<int>(entity) = i;
+        }
+    }
+
+    auto view = manager.view<Position, Velocity>();
+    REQUIRE(view.size() == 5);
+
+    view.each([] (ge::thing::Entity, Position& position, Velocity& velocity) {
+        position.x += velocity.dx;
+    });
+
+    int sum = 0;
+    const auto& constManager = manager;
+    constManager.view<Position>().eachChunk(
+        [&sum] (
+                std::span<const ge::thing::Entity> entities,
+                std::span<const Position> positions) {
+            REQUIRE(entities.size() == positions.size());
+            for (const auto& position : positions) {
+                sum += position.x;
+            }
+        });
+    REQUIRE(sum == 45 + 5);
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <thing.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace {
+
+struct Health {
+    int value;
+};
+
+struct Dead {};
+
+} // namespace
+
+TEST_CASE("Command buffer", "[commands]")
+{
+    ge::thing::EntityManager manager;
+    auto e1 = manager.createEntity();
+    auto e2 = manager.createEntity();
+    manager.add<Health>(e1).value = 0;
+    manager.add<Health>(e2).value = 10;
+
+    ge::thing::CommandBuffer commands{manager};
+    for (auto [entity, health] : manager.view<Health>()) {
+        if (health.value <= 0) {
+            commands.add<Dead>(entity);
+            commands.killEntity(entity);
+        } else {
+            auto child = commands.createEntity();
+            commands.add<Health>(child, Health{health.value / 2});
+            commands.add<std::string>(child, "child");
+            commands.remove<Health>(entity);
+        }
+    }
+
+    REQUIRE(manager.components<Health>().size() == 2);
+    REQUIRE(!commands.empty());
+
+    commands.apply();
+
+    REQUIRE(commands.empty());
+    REQUIRE(!manager.alive(e1));
+    REQUIRE(manager.alive(e2));
+    REQUIRE(!manager.has<Health>(e2));
+    REQUIRE(manager.entities<Dead>().empty());
+    REQUIRE(manager.components<Health>().size() == 1);
+    REQUIRE(manager.components<Health>()[0].value == 5);
+
+    auto child = manager.entities<Health>()[0];
+    REQUIRE(manager.alive(child));
+    REQUIRE(manager.has<std::string>(child));
+
+    auto next = manager.createEntity();
+    REQUIRE(next != child);
+}
+
+TEST_CASE("Scheduler applies command buffers", "[commands]")
+{
+    using ge::thing::Read;
+
+    auto pool = std::make_unique<ge::thing::ThreadPool>(4);
+    ge::thing::EntityManager manager;
+    for (int i = 0; i < 1000; i++) {
+        manager.add<Health>(manager.createEntity()).value = i % 2;
+    }
+
+    ge::thing::Scheduler scheduler;
+    scheduler.add<Read<Health>>(
+        [] (const ge::thing::EntityManager& manager,
+                ge::thing::CommandBuffer& commands) {
+            for (auto [entity, health] : manager.view<const Health>()) {
+                if (health.value == 0) {
+                    commands.killEntity(entity);
+                }
+            }
+        });
+    scheduler.add<Read<Health>>(
+        [&pool] (const ge::thing::EntityManager& manager,
+                ge::thing::CommandBuffer& commands) {
+            ge::thing::ThreadCommandBuffers threadCommands{commands};
+            manager.parallelEach<const Health>(
+                *pool,
+                [&] (ge::thing::Entity, const Health& health) {
+                    if (health.value == 1) {
+                        auto& local = threadCommands.local();
+                        local.add<Dead>(local.createEntity());
+                    }
+                });
+            commands.add<std::string>(commands.createEntity(), "spawner");
+            commands.append(threadCommands.merge());
+        });
+
+    scheduler.run(manager, *pool);
+
+    REQUIRE(manager.components<Health>().size() == 500);
+    REQUIRE(manager.entities<Dead>().size() == 500);
+    REQUIRE(manager.components<std::string>().size() == 1);
+}
+
+TEST_CASE("Thread command buffers merge in worker order", "[commands]")
+{
+    ge::thing::ThreadPool first{2};
+    ge::thing::ThreadPool second{1};
+    ge::thing::EntityManager manager;
+    auto entity = manager.createEntity();
+
+    ge::thing::ThreadCommandBuffers threadCommands{manager};
+    auto record = [&] (ge::thing::ThreadPool& pool, int value) {
+        // Wait for the task without helping, so that a worker runs it.
+        std::atomic<bool> done = false;
+        pool.submit([&] {
+            auto& local = threadCommands.local();
+            REQUIRE(&threadCommands.local() == &local);
+            local.add<Health>(entity, Health{value});
+            done = true;
+            done.notify_one();
+        });
+        done.wait(false);
+    };
+    record(second, 3);
+    record(first, 1);
+    record(first, 1);
+    threadCommands.local().add<Health>(entity, Health{2});
+
+    threadCommands.apply();
+
+    // The buffer of the main thread goes first, although it recorded last,
+    // then those of the workers of the first pool, then of the second one.
+    REQUIRE(manager.component<Health>(entity).value == 3);
+}
+
+TEST_CASE("Removals alone do not create pools", "[commands]")
+{
+    ge::thing::EntityManager manager;
+    auto entity = manager.createEntity();
+
+    ge::thing::CommandBuffer commands{manager};
+    commands.remove<Health>(entity);
+    commands.apply();
+
+    REQUIRE(manager.statistics().pools.empty());
+}
@@ -0,0 +1,250 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <thing.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Named {
+    int value;
+};
+
+struct Position {
+    float x;
+    float y;
+};
+
+struct Packed {
+    using Storage = ge::thing::storage::Columns;
+    float a, b;
+    static constexpr auto fields = std::tuple{&Packed::a, &Packed::b};
+};
+
+// Layout of a component that only scripts know about.
+struct Health {
+    float current;
+    float maximum;
+};
+
+int liveValues = 0;
+
+ge::thing::ComponentInfo healthInfo(std::string name)
+{
+    ge::thing::ComponentInfo info;
+    info.name = std::move(name);
+    info.size = sizeof(Health);
+    info.alignment = alignof(Health);
+    return info;
+}
+
+ge::thing::ComponentInfo countedInfo(std::string name)
+{
+    auto info = healthInfo(std::move(name));
+    info.construct = [] (void* address) {
+        new (address) Health{100, 100};
+        ++liveValues;
+    };
+    info.copy = [] (void* target, const void* source) {
+        std::memcpy(target, source, sizeof(Health));
+        ++liveValues;
+    };
+    info.move = [] (void* target, void* source) {
+        std::memcpy(target, source, sizeof(Health));
+        ++liveValues;
+    };
+    info.destroy = [] (void* address) {
+        std::memset(address, 0, sizeof(Health));
+        --liveValues;
+    };
+    return info;
+}
+
+// Sections run the test case again, which must not register twice.
+ge::thing::ComponentId registered(ge::thing::ComponentInfo info)
+{
+    auto& registry = ge::thing::componentRegistry();
+    if (auto known = registry.find(info.name)) {
+        return known->id;
+    }
+    return registry.add(std::move(info));
+}
+
+} // namespace
+
+TEST_CASE("Component registry", "[registry]")
+{
+    auto& registry = ge::thing::componentRegistry();
+
+    auto named = registry.add<Named>("registry.named");
+    REQUIRE(named == ge::thing::componentId<Named>());
+    REQUIRE(registry.add<Named>("registry.named") == named);
+    REQUIRE(registry.find("registry.named")->size == sizeof(Named));
+    REQUIRE(registry.at(named).name == "registry.named");
+    REQUIRE_THROWS_AS(
+        registry.add<Named>("registry.other"), std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        registry.add<Position>("registry.named"), std::invalid_argument);
+
+    auto health = registry.add(healthInfo("registry.health"));
+    REQUIRE(health != named);
+    REQUIRE(registry.find(health)->createPool == nullptr);
+    REQUIRE_THROWS_AS(
+        registry.add(healthInfo("registry.health")), std::invalid_argument);
+
+    auto bad = healthInfo("registry.bad");
+    bad.alignment = 3;
+    REQUIRE_THROWS_AS(registry.add(bad), std::invalid_argument);
+    REQUIRE(!registry.find("registry.bad"));
+    REQUIRE(!registry.find(health + 1000));
+    REQUIRE_THROWS_AS(registry.at(health + 1000), std::out_of_range);
+}
+
+TEST_CASE("Components by ID", "[registry]")
+{
+    auto& registry = ge::thing::componentRegistry();
+    auto position = registry.add<Position>("by-id.position");
+    auto health = registered(healthInfo("by-id.health"));
+
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(100);
+
+    SECTION("C++ components")
+    {
+        Position value{1, 2};
+        auto added = static_cast<Position*>(
+            manager.add(entities[0], position, &value));
+        REQUIRE(added == &manager.component<Position>(entities[0]));
+        REQUIRE(manager.has(entities[0], position));
+        REQUIRE(!manager.has(entities[1], position));
+        manager.add<Position>(entities[1], Position{3, 4});
+
+        auto data = static_cast<const Position*>(
+            std::as_const(manager).data(position));
+        REQUIRE(manager.entities(position).size() == 2);
+        REQUIRE(data[1].x == 3);
+
+        auto since = manager.advanceTick();
+        static_cast<Position*>(manager.component(entities[1], position))
+            ->y = 5;
+        REQUIRE(manager.component<Position>(entities[1]).y == 5);
+        size_t changed = 0;
+        for (auto [entity, p] : manager.view<
+                ge::thing::Changed<const Position>>(since)) {
+            REQUIRE(p.y == 5);
+            ++changed;
+        }
+        REQUIRE(changed == 1);
+
+        manager.remove(entities[0], position);
+        REQUIRE(!manager.has<Position>(entities[0]));
+        REQUIRE_THROWS_AS(
+            manager.component(entities[0], position), std::out_of_range);
+    }
+
+    SECTION("Runtime components")
+    {
+        for (auto entity : entities) {
+            Health value{static_cast<float>(entity.index()), 100};
+            manager.add(entity, health, &value);
+        }
+        manager.killEntity(entities[10]);
+        manager.remove(entities[20], health);
+        REQUIRE(!manager.has(entities[20], health));
+
+        auto owners = manager.entities(health);
+        auto values = static_cast<Health*>(manager.data(health));
+        REQUIRE(owners.size() == 98);
+        for (size_t i = 0; i < owners.size(); i++) {
+            REQUIRE(values[i].current ==
+                static_cast<float>(owners[i].index()));
+            values[i].current = 0;
+        }
+        auto first = static_cast<const Health*>(
+            std::as_const(manager).component(entities[5], health));
+        REQUIRE(first->current == 0);
+
+        auto fresh = static_cast<Health*>(manager.add(entities[20], health));
+        REQUIRE(fresh->current == 0);
+        REQUIRE(fresh->maximum == 0);
+
+        auto copy = manager.clone();
+        REQUIRE(copy.entities(health).size() == 99);
+        manager.killEntities(entities);
+        REQUIRE(copy.has(entities[5], health));
+
+        auto spawned = copy.spawn(entities[5], 3);
+        REQUIRE(copy.entities(health).size() == 102);
+
+        ge::thing::EntityManager target;
+        auto migrated = copy.migrate(spawned, target);
+        REQUIRE(target.entities(health).size() == 3);
+        REQUIRE(copy.entities(health).size() == 99);
+
+        auto statistics = target.statistics();
+        REQUIRE(statistics.pools.size() == 1);
+        REQUIRE(statistics.pools[0].component == health);
+        copy.compact();
+    }
+
+    SECTION("Lifetime")
+    {
+        auto counted = registered(countedInfo("by-id.counted"));
+        {
+            ge::thing::EntityManager world;
+            auto created = world.createEntities(50);
+            for (auto entity : created) {
+                auto value = static_cast<Health*>(world.add(entity, counted));
+                REQUIRE(value->maximum == 100);
+            }
+            REQUIRE(liveValues == 50);
+            world.add(created[0], counted);
+            world.killEntity(created[1]);
+            REQUIRE(liveValues == 49);
+            auto copy = world.clone();
+            REQUIRE(liveValues == 98);
+        }
+        REQUIRE(liveValues == 0);
+
+        // Copying an entity onto itself keeps its value.
+        {
+            ge::thing::internals::RawComponents pool{
+                registry.at(counted), std::pmr::get_default_resource()};
+            Health value{7, 100};
+            auto prototype = ge::thing::Entity{0};
+            pool.addRaw(prototype, &value);
+            std::vector targets{prototype, ge::thing::Entity{1}};
+            pool.copyEntity(prototype, targets);
+            REQUIRE(liveValues == 2);
+            REQUIRE(static_cast<const Health*>(
+                pool.findRaw(prototype))->current == 7);
+            REQUIRE(static_cast<const Health*>(
+                pool.findRaw(targets[1]))->current == 7);
+        }
+        REQUIRE(liveValues == 0);
+    }
+
+    SECTION("Errors")
+    {
+        REQUIRE_THROWS_AS(
+            manager.add(entities[0], health + 1000), std::out_of_range);
+        manager.killEntity(entities[0]);
+        REQUIRE_THROWS_AS(
+            manager.add(entities[0], health), std::invalid_argument);
+        REQUIRE(manager.entities(health + 1000).empty());
+        REQUIRE(!manager.data(health + 1000));
+
+        auto packed = registry.add<Packed>("by-id.packed");
+        manager.add<Packed>(entities[1], Packed{1, 2});
+        REQUIRE(!manager.data(packed));
+        REQUIRE_THROWS_AS(
+            manager.component(entities[1], packed), std::logic_error);
+    }
+}
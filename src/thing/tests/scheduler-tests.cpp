@@ -0,0 +1,308 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <thing.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Position {
+    int x;
+};
+
+struct Velocity {
+    int dx;
+};
+
+template <class Manager, class Component>
+concept canMarkChanged = requires (Manager& manager, ge::thing::Entity e) {
+    manager.template markChanged<Component>(e);
+};
+
+// Returns true if `count` threads manage to meet here within a time limit,
+// i.e. if they really run concurrently.
+bool meet(std::atomic<int>& arrived, int count)
+{
+    ++arrived;
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (arrived < count) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Task group", "[threads]")
+{
+    ge::thing::ThreadPool pool{4};
+
+    std::atomic<int> sum = 0;
+    {
+        ge::thing::TaskGroup group{pool};
+        for (int i = 1; i <= 100; i++) {
+            group.run([&sum, &pool, i] {
+                ge::thing::TaskGroup nested{pool};
+                nested.run([&sum, i] { sum += i; });
+                nested.wait();
+            });
+        }
+        group.wait();
+    }
+    REQUIRE(sum == 5050);
+
+    ge::thing::TaskGroup failing{pool};
+    failing.run([] { throw std::runtime_error{"failure"}; });
+    REQUIRE_THROWS_AS(failing.wait(), std::runtime_error);
+}
+
+TEST_CASE("Task groups across pools", "[threads]")
+{
+    ge::thing::ThreadPool outer{8};
+    ge::thing::ThreadPool inner{1};
+
+    std::atomic<int> sum = 0;
+    std::atomic<bool> outerWorkers = true;
+    ge::thing::TaskGroup group{outer};
+    for (int i = 1; i <= 100; i++) {
+        group.run([&, i] {
+            // The waiting thread runs tasks too, as no worker.
+            auto worker = ge::thing::ThreadPool::currentWorker();
+            if (worker.pool == &outer ?
+                    worker.index >= 8 : worker.pool != nullptr) {
+                outerWorkers = false;
+            }
+            // Workers of the outer pool are foreign to the inner one, which
+            // has fewer queues than their indices.
+            ge::thing::TaskGroup nested{inner};
+            nested.run([&sum, i] { sum += i; });
+            nested.wait();
+        });
+    }
+    group.wait();
+
+    REQUIRE(sum == 5050);
+    REQUIRE(outerWorkers);
+    REQUIRE(ge::thing::ThreadPool::currentWorker().pool == nullptr);
+}
+
+TEST_CASE("Scheduler orders conflicting systems", "[scheduler]")
+{
+    using ge::thing::Read;
+    using ge::thing::Write;
+
+    ge::thing::EntityManager manager;
+    auto entity = manager.createEntity();
+    manager.add<Position>(entity).x = 0;
+    manager.add<Velocity>(entity).dx = 0;
+
+    std::mutex mutex;
+    std::vector<std::string> order;
+    int rendered = 0;
+    auto record = [&] (std::string name) {
+        std::lock_guard lock{mutex};
+        order.push_back(std::move(name));
+    };
+
+    using ge::thing::SystemManager;
+
+    ge::thing::Scheduler scheduler;
+    scheduler.add<Write<Velocity>>(
+        [&] (SystemManager<Write<Velocity>>& manager) {
+            manager.component<Velocity>(entity).dx = 2;
+            record("accelerate");
+        });
+    scheduler.add<Read<Velocity>, Write<Position>>(
+        [&] (SystemManager<Read<Velocity>, Write<Position>>& manager) {
+            for (auto [e, position, velocity] :
+                    manager.view<Position, const Velocity>()) {
+                position.x += velocity.dx;
+            }
+            record("move");
+        });
+    scheduler.add(ge::thing::System<Read<Position>>{
+        [&] (const ge::thing::EntityManager& manager) {
+            rendered = manager.component<Position>(entity).x;
+            record("render");
+        }});
+
+    ge::thing::ThreadPool pool{4};
+    scheduler.run(manager, pool);
+
+    REQUIRE(order == std::vector<std::string>{"accelerate", "move", "render"});
+    REQUIRE(rendered == 2);
+}
+
+TEST_CASE("Read-only systems get a const entity manager", "[scheduler]")
+{
+    using ge::thing::Exclusive;
+    using ge::thing::Read;
+    using ge::thing::System;
+    using ge::thing::Write;
+
+    using Mixed = ge::thing::SystemManager<Read<Position>, Write<Velocity>>;
+    using Mutable = void (*)(ge::thing::EntityManager&);
+    using Const = void (*)(const ge::thing::EntityManager&);
+    using Accessor = void (*)(Mixed&);
+
+    static_assert(!std::constructible_from<System<Read<Position>>, Mutable>);
+    static_assert(std::constructible_from<System<Read<Position>>, Const>);
+    static_assert(!std::constructible_from<
+        System<Read<Position>, Write<Velocity>>, Mutable>);
+    static_assert(std::constructible_from<
+        System<Read<Position>, Write<Velocity>>, Accessor>);
+    static_assert(std::constructible_from<System<Exclusive>, Mutable>);
+    static_assert(std::constructible_from<
+        System<Exclusive, Read<Position>>, Mutable>);
+}
+
+TEST_CASE("Mixed systems only write what they declare", "[scheduler]")
+{
+    using ge::thing::Changed;
+    using ge::thing::Read;
+    using ge::thing::Write;
+    using Mixed = ge::thing::SystemManager<Read<Position>, Write<Velocity>>;
+
+    ge::thing::EntityManager manager;
+    auto entity = manager.createEntity();
+    manager.add<Position>(entity).x = 3;
+    manager.add<Velocity>(entity).dx = 0;
+    auto since = manager.advanceTick();
+
+    static_assert(std::same_as<
+        decltype(std::declval<Mixed&>().component<Position>(entity)),
+        const Position&>);
+    static_assert(std::same_as<
+        decltype(std::declval<Mixed&>().component<Velocity>(entity)),
+        Velocity&>);
+    static_assert(std::same_as<
+        decltype(std::declval<Mixed&>().view<Position, Velocity>()),
+        ge::thing::View<const Position, Velocity>>);
+    static_assert(!canMarkChanged<Mixed, Position>);
+    static_assert(canMarkChanged<Mixed, Velocity>);
+
+    int read = 0;
+    ge::thing::Scheduler scheduler;
+    scheduler.add<Read<Position>, Write<Velocity>>([&] (Mixed& manager) {
+        for (auto [e, position, velocity] :
+                manager.view<Position, Velocity>()) {
+            velocity.dx = position.x;
+        }
+        read = manager.component<Position>(entity).x;
+        manager.components<Velocity>()[0].dx *= 2;
+    });
+    ge::thing::ThreadPool pool{2};
+    scheduler.run(manager, pool);
+
+    REQUIRE(read == 3);
+    REQUIRE(manager.component<Velocity>(entity).dx == 6);
+    auto count = [] (auto view) {
+        size_t count = 0;
+        for (auto&& tuple : view) {
+            (void)tuple;
+            ++count;
+        }
+        return count;
+    };
+    REQUIRE(count(manager.view<Changed<const Position>>(since)) == 0);
+    REQUIRE(count(manager.view<Changed<const Velocity>>(since)) == 1);
+}
+
+TEST_CASE("Scheduler runs independent systems concurrently", "[scheduler]")
+{
+    using ge::thing::Read;
+    using ge::thing::Write;
+
+    ge::thing::EntityManager manager;
+    ge::thing::ThreadPool pool{2};
+
+    std::atomic<int> arrived = 0;
+    std::atomic<int> met = 0;
+    auto system = [&] (auto&) {
+        if (meet(arrived, 2)) {
+            ++met;
+        }
+    };
+
+    ge::thing::Scheduler scheduler;
+    scheduler.add<Write<Position>, Read<int>>(system);
+    scheduler.add<Write<Velocity>, Read<int>>(system);
+    scheduler.run(manager, pool);
+
+    REQUIRE(met == 2);
+}
+
+TEST_CASE("Exclusive systems run alone", "[scheduler]")
+{
+    using ge::thing::Exclusive;
+    using ge::thing::Read;
+
+    ge::thing::EntityManager manager;
+    ge::thing::ThreadPool pool{4};
+
+    std::atomic<int> running = 0;
+    std::atomic<bool> overlapped = false;
+    auto system = [&] (const ge::thing::EntityManager&) {
+        if (running++ > 0) {
+            overlapped = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        --running;
+    };
+
+    ge::thing::Scheduler scheduler;
+    scheduler.add<Read<Position>>(system);
+    scheduler.add<Exclusive>(system);
+    scheduler.add<Read<Velocity>>(system);
+    scheduler.run(manager, pool);
+
+    REQUIRE(!overlapped);
+}
+
+TEST_CASE("Parallel each", "[threads]")
+{
+    ge::thing::EntityManager manager;
+    for (int i = 0; i < 100000; i++) {
+        auto entity = manager.createEntity();
+        manager.add<Position>(entity).x = i;
+        if (i % 3 == 0) {
+            manager.add<Velocity>(entity).dx = 2;
+        }
+    }
+
+    ge::thing::ThreadPool pool{4};
+    manager.parallelEach<Position, const Velocity>(
+        pool,
+        [] (ge::thing::Entity, Position& position, const Velocity& velocity) {
+            position.x += velocity.dx;
+        });
+
+    long long sum = 0;
+    for (const auto& position : manager.components<Position>()) {
+        sum += position.x;
+    }
+    REQUIRE(sum == 4999950000LL + 33334 * 2);
+
+    std::atomic<int> count = 0;
+    manager.view<Position>().parallelEach(
+        pool,
+        [&count] (ge::thing::Entity, Position&) { ++count; },
+        1000);
+    REQUIRE(count == 100000);
+
+    REQUIRE_THROWS_AS(
+        manager.view<Position>().parallelEach(
+            pool, [] (ge::thing::Entity, Position&) {}, 0),
+        std::invalid_argument);
+}
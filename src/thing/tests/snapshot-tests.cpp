@@ -0,0 +1,445 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <thing.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <limits>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Position {
+    float x;
+    float y;
+};
+
+struct Asleep {};
+
+struct Level {
+    using Storage = ge::thing::storage::Singleton;
+    int number;
+};
+
+struct Chunk {
+    using Storage = ge::thing::storage::Paged;
+    int values[4];
+};
+
+std::vector<std::byte> bytes(const std::string& string)
+{
+    auto data = reinterpret_cast<const std::byte*>(string.data());
+    return {data, data + string.size()};
+}
+
+} // namespace
+
+TEST_CASE("Snapshot", "[snapshot]")
+{
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(5000);
+    for (auto entity : entities) {
+        auto index = static_cast<float>(entity.index());
+        manager.add<Position>(entity, {index, -index});
+        if (entity.index() % 7 == 0) {
+            manager.add<Asleep>(entity);
+        }
+        if (entity.index() % 100 == 0) {
+            manager.add<Chunk>(entity).values[3] =
+                static_cast<int>(entity.index());
+        }
+    }
+    manager.add<Level>(entities[43]).number = 3;
+    for (size_t i = 0; i < entities.size(); i += 3) {
+        manager.killEntity(entities[i]);
+    }
+    manager.advanceTick();
+
+    std::ostringstream stream;
+    manager.save<Position, Asleep, Level, Chunk>(stream);
+    auto snapshot = bytes(stream.str());
+
+    SECTION("Restore")
+    {
+        ge::thing::EntityManager restored;
+        auto stale = restored.createEntity();
+        restored.add<std::string>(stale, "dropped");
+
+        restored.load<Position, Asleep, Level, Chunk>(snapshot);
+
+        REQUIRE(restored.tick() == manager.tick());
+        REQUIRE(!restored.has<std::string>(stale));
+        for (size_t i = 0; i < entities.size(); i++) {
+            auto entity = entities[i];
+            REQUIRE(restored.alive(entity) == manager.alive(entity));
+            if (!manager.alive(entity)) {
+                continue;
+            }
+            REQUIRE(restored.component<Position>(entity).x ==
+                static_cast<float>(entity.index()));
+            REQUIRE(restored.has<Asleep>(entity) ==
+                manager.has<Asleep>(entity));
+            REQUIRE(restored.has<Chunk>(entity) ==
+                manager.has<Chunk>(entity));
+        }
+        REQUIRE(restored.singleton<Level>().number == 3);
+        REQUIRE(restored.components<Position>().size() ==
+            manager.components<Position>().size());
+
+        // The free list survives, so recycled handles match.
+        REQUIRE(restored.createEntity() == manager.createEntity());
+    }
+
+    SECTION("Groups")
+    {
+        ge::thing::EntityManager restored;
+        auto group = restored.group<Position, Chunk>();
+        restored.load<Position, Asleep, Level, Chunk>(snapshot);
+
+        REQUIRE(group.size() == 33);
+        for (auto [entity, position, chunk] : group) {
+            REQUIRE(position.x == static_cast<float>(entity.index()));
+            REQUIRE(chunk.values[3] == static_cast<int>(entity.index()));
+        }
+        REQUIRE(restored.group<Position, Chunk>().size() == 33);
+        restored.add<Chunk>(entities[1]);
+        REQUIRE(group.size() == 34);
+        restored.killEntity(entities[100]);
+        REQUIRE(group.size() == 33);
+    }
+
+    SECTION("Memory-mapped file")
+    {
+        auto path = std::filesystem::temp_directory_path() /
+            "ge-thing-snapshot-test.bin";
+        {
+            std::ofstream file{path, std::ios::binary};
+            manager.save<Position, Asleep, Level, Chunk>(file);
+        }
+
+        ge::thing::EntityManager restored;
+        {
+            ge::thing::MappedFile file{path};
+            REQUIRE(file.bytes().size() == snapshot.size());
+            restored.load<Position, Asleep, Level, Chunk>(file.bytes());
+        }
+        std::filesystem::remove(path);
+
+        int count = 0;
+        for (auto [entity, position, chunk] :
+                restored.view<const Position, const Chunk>()) {
+            REQUIRE(chunk.values[3] == static_cast<int>(entity.index()));
+            ++count;
+        }
+        REQUIRE(count == 33);
+    }
+
+    SECTION("Mismatch")
+    {
+        ge::thing::EntityManager restored;
+        auto entity = restored.createEntity();
+        restored.add<Position>(entity, {1, 2});
+
+        REQUIRE_THROWS_AS(
+            restored.load<Position>(snapshot), std::runtime_error);
+        REQUIRE_THROWS_AS(
+            (restored.load<Chunk, Asleep, Level, Position>(snapshot)),
+            std::runtime_error);
+        auto truncated = std::span{snapshot}.first(snapshot.size() - 1);
+        REQUIRE_THROWS_AS(
+            (restored.load<Position, Asleep, Level, Chunk>(truncated)),
+            std::runtime_error);
+
+        // A failed load leaves the manager as it was.
+        REQUIRE(restored.alive(entity));
+        REQUIRE(restored.component<Position>(entity).y == 2);
+    }
+
+    SECTION("Corrupted free list")
+    {
+        ge::thing::EntityManager small;
+        auto created = small.createEntities(10);
+        small.killEntity(created[3]);
+        small.killEntity(created[5]);
+        small.killEntity(created[7]);
+        std::ostringstream smallStream;
+        small.save<Position>(smallStream);
+        auto valid = bytes(smallStream.str());
+
+        // The slots follow the header, the tick and the slot count. The
+        // free list runs 7, 5, 3 through the index halves of dead slots.
+        constexpr size_t slots = 4 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+        auto corrupt = [&] (
+                std::initializer_list<std::pair<size_t, uint32_t>> links) {
+            auto data = valid;
+            for (auto [slot, next] : links) {
+                std::memcpy(&data[slots + slot * sizeof(ge::thing::Entity)],
+                    &next, sizeof(next));
+            }
+            ge::thing::EntityManager restored;
+            REQUIRE_THROWS_AS(
+                restored.load<Position>(data), std::runtime_error);
+        };
+        corrupt({{7, 1000}});
+        corrupt({{7, 2}});
+        corrupt({{7, 3}});
+        corrupt({{5, 7}});
+        corrupt({{3, 5}});
+
+        ge::thing::EntityManager restored;
+        restored.load<Position>(valid);
+        REQUIRE(restored.createEntity().index() == 7);
+        REQUIRE(restored.createEntity().index() == 5);
+        REQUIRE(restored.createEntity().index() == 3);
+        REQUIRE(restored.createEntity().index() == 10);
+    }
+
+    SECTION("Corrupted index")
+    {
+        ge::thing::EntityManager small;
+        auto created = small.createEntities(10);
+        for (auto it = created.rbegin(); it != created.rend(); ++it) {
+            small.add<Position>(*it, {0, 0});
+        }
+        std::ostringstream smallStream;
+        small.save<Position>(smallStream);
+        auto valid = bytes(smallStream.str());
+
+        // The page of the index starts with the dense indices 9 to 0.
+        std::vector<uint32_t> entries{9, 8, 7, 6, 5, 4, 3, 2, 1, 0};
+        auto pattern = std::as_bytes(std::span{entries});
+        auto page = std::search(
+            valid.begin(), valid.end(), pattern.begin(), pattern.end());
+        REQUIRE(page != valid.end());
+        auto offset = page - valid.begin();
+
+        auto corrupt = [&] (size_t slot, uint32_t index) {
+            auto data = valid;
+            std::memcpy(&data[static_cast<size_t>(offset) +
+                slot * sizeof(uint32_t)], &index, sizeof(index));
+            ge::thing::EntityManager restored;
+            REQUIRE_THROWS_AS(
+                restored.load<Position>(data), std::runtime_error);
+        };
+        corrupt(3, 10);
+        corrupt(3, 5);
+        corrupt(3, std::numeric_limits<uint32_t>::max());
+        corrupt(20, 2);
+
+        ge::thing::EntityManager restored;
+        restored.load<Position>(valid);
+        REQUIRE(restored.has<Position>(created[3]));
+    }
+}
+
+TEST_CASE("Delta", "[snapshot]")
+{
+    ge::thing::EntityManager source;
+    auto entities = source.createEntities(1000);
+    for (auto entity : entities) {
+        auto index = static_cast<float>(entity.index());
+        source.add<Position>(entity, {index, 0});
+    }
+    source.add<Asleep>(entities[1]);
+
+    std::ostringstream stream;
+    source.save<Position, Asleep>(stream);
+    ge::thing::EntityManager target;
+    target.load<Position, Asleep>(bytes(stream.str()));
+
+    ge::thing::DeltaEncoder<Position, Asleep> encoder{source};
+    std::vector<std::byte> delta;
+
+    auto sync = [&] {
+        encoder.encode(delta);
+        ge::thing::applyDelta<Position, Asleep>(target, delta);
+    };
+
+    // Mutable access would mark the components as changed.
+    const auto& constSource = source;
+    const auto& constTarget = target;
+    auto same = [&] {
+        for (size_t index = 0; index < 1100; index++) {
+            auto slot = static_cast<ge::thing::Entity::IndexType>(index);
+            for (ge::thing::Entity::GenerationType generation = 0;
+                    generation < 3; generation++) {
+                auto entity = ge::thing::Entity{slot, generation};
+                REQUIRE(target.alive(entity) == source.alive(entity));
+                if (!source.alive(entity)) {
+                    continue;
+                }
+                REQUIRE(target.has<Asleep>(entity) ==
+                    source.has<Asleep>(entity));
+                REQUIRE(target.has<Position>(entity) ==
+                    source.has<Position>(entity));
+                if (source.has<Position>(entity)) {
+                    REQUIRE(constTarget.component<Position>(entity).y ==
+                        constSource.component<Position>(entity).y);
+                }
+            }
+        }
+    };
+
+    sync();
+    auto emptySize = delta.size();
+    same();
+
+    source.component<Position>(entities[10]).y = 1;
+    source.component<Position>(entities[900]).y = 2;
+    source.killEntity(entities[20]);
+    source.remove<Asleep>(entities[1]);
+    source.add<Asleep>(entities[2]);
+    source.remove<Position>(entities[3]);
+    auto created = source.createEntity();
+    source.add<Position>(created, {0, 3});
+    auto reserved = source.reserveEntity();
+    source.flushReserved();
+    source.add<Position>(reserved, {0, 4});
+    source.add<std::string>(entities[4], "not encoded");
+    source.remove<std::string>(entities[4]);
+
+    sync();
+    REQUIRE(created.index() == 20);
+    REQUIRE(delta.size() < emptySize + 200);
+    same();
+
+    // Nothing changed since the last encode.
+    sync();
+    REQUIRE(delta.size() == emptySize);
+
+    SECTION("Buffer is reused")
+    {
+        source.component<Position>(entities[10]).y = 5;
+        auto capacity = delta.capacity();
+        auto data = delta.data();
+        sync();
+        REQUIRE(delta.capacity() == capacity);
+        REQUIRE(delta.data() == data);
+        same();
+    }
+
+    SECTION("Bad created entities")
+    {
+        source.killEntity(entities[30]);
+        sync();
+        auto slots = target.statistics().entitySlots;
+
+        auto created = [] (ge::thing::Entity entity) {
+            std::vector<std::byte> data;
+            auto append = [&data] (const auto& value) {
+                auto bytes = std::as_bytes(std::span{&value, 1});
+                data.insert(data.end(), bytes.begin(), bytes.end());
+            };
+            append(ge::thing::internals::DeltaMagic);
+            append(ge::thing::internals::DeltaVersion);
+            append(uint32_t{2});
+            append(uint64_t{1100});
+            append(uint64_t{1});
+            append(ge::thing::internals::Journal::Kind::Created);
+            append(entity);
+            append(uint32_t{0});
+            return data;
+        };
+        auto requireBad = [&target, &created] (ge::thing::Entity entity) {
+            REQUIRE_THROWS_AS(
+                (ge::thing::applyDelta<Position, Asleep>(
+                    target, created(entity))),
+                std::runtime_error);
+        };
+
+        // A stale handle, a slot in use, and an index past the slots of the
+        // source.
+        requireBad(entities[30]);
+        requireBad(ge::thing::Entity{20, 0});
+        requireBad(ge::thing::Entity{1100, 0});
+        requireBad(ge::thing::Entity{0xfffffff0, 0});
+        REQUIRE(!target.alive(entities[30]));
+        REQUIRE(target.statistics().entitySlots == slots);
+    }
+
+    SECTION("Far handle")
+    {
+        // The slots up to the handle are added as dead ones, on both sides.
+        source.createEntity(ge::thing::Entity{1050, 0});
+        source.add<Position>(ge::thing::Entity{1050, 0}, {0, 6});
+        sync();
+        same();
+        REQUIRE(target.statistics().entitySlots == 1051);
+
+        auto gap = source.createEntity();
+        sync();
+        REQUIRE(gap.index() >= 1002);
+        REQUIRE(gap.index() < 1050);
+        same();
+    }
+
+    SECTION("Long free list")
+    {
+        for (size_t i = 100; i < entities.size(); i++) {
+            source.killEntity(entities[i]);
+        }
+        sync();
+        same();
+
+        // The target replays the relink of the source, so their free lists
+        // keep matching, through a compaction done in steps too.
+        source.compact();
+        auto recreated = source.createEntities(400);
+        sync();
+        REQUIRE(recreated.front().index() == 100);
+        same();
+        auto more = source.createEntities(3000);
+        for (size_t i = 0; i < more.size(); i += 2) {
+            source.killEntity(more[i]);
+        }
+        sync();
+        size_t steps = 0;
+        for (size_t i = 1; ; i += 2, steps++) {
+            bool done = source.compact(std::chrono::steady_clock::duration{0});
+            source.killEntity(more[i]);
+            source.createEntity();
+            sync();
+            if (done) {
+                break;
+            }
+        }
+        REQUIRE(steps > 1);
+        same();
+        // The free slots are taken in the same order on both sides.
+        auto fresh = target.createEntities(2000);
+        REQUIRE(fresh == source.createEntities(2000));
+    }
+
+    SECTION("Clone")
+    {
+        source.killEntity(entities[30]);
+        auto copy = source.clone();
+        copy.killEntity(entities[31]);
+        ge::thing::DeltaEncoder<Position, Asleep> copyEncoder{copy};
+        std::vector<std::byte> copyDelta;
+        copyEncoder.encode(copyDelta);
+        REQUIRE(copyDelta.size() == emptySize);
+        sync();
+        same();
+    }
+
+    SECTION("Mismatch")
+    {
+        REQUIRE_THROWS_AS(
+            (ge::thing::applyDelta<Asleep, Position>(target, delta)),
+            std::runtime_error);
+        REQUIRE_THROWS_AS(
+            ge::thing::DeltaEncoder<Position>{source}, std::logic_error);
+    }
+}
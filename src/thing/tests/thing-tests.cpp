@@ -2,7 +2,18 @@
 
 #include <thing.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory_resource>
+#include <span>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 struct C1 {
     int id;
@@ -62,7 +73,41 @@ TEST_CASE("Entity creation", "[entities]")
     REQUIRE(e1 == 1);
     REQUIRE(e2 == 2);
 
-    // TODO: kill entities
+    manager.add<int>(e1) = 1;
+    manager.add<std::string>(e1) = "one";
+    manager.killEntity(e1);
+
+    REQUIRE(!manager.alive(e1));
+    REQUIRE(manager.alive(e0));
+    REQUIRE(manager.components<int>().empty());
+    REQUIRE(manager.components<std::string>().empty());
+
+    auto e3 = manager.createEntity();
+
+    REQUIRE(e3.index() == e1.index());
+    REQUIRE(e3.generation() == e1.generation() + 1);
+    REQUIRE(e3 != e1);
+    REQUIRE(manager.alive(e3));
+    REQUIRE(!manager.alive(e1));
+
+    manager.add<int>(e3) = 3;
+
+    REQUIRE(!manager.has<int>(e1));
+    REQUIRE_THROWS_AS(manager.component<int>(e1), std::out_of_range);
+    REQUIRE_THROWS_AS(manager.add<int>(e1), std::invalid_argument);
+
+    manager.killEntity(e1);
+
+    REQUIRE(manager.component<int>(e3) == 3);
+
+    // Handles older than their slot cannot be made alive again.
+    manager.killEntity(e3);
+    REQUIRE_THROWS_AS(manager.createEntity(e1), std::invalid_argument);
+    REQUIRE_THROWS_AS(manager.createEntity(e3), std::invalid_argument);
+    REQUIRE(!manager.alive(e3));
+    auto e4 = manager.createEntity(
+        ge::thing::Entity{e3.index(), e3.generation() + 1});
+    REQUIRE(manager.alive(e4));
 }
 
 TEST_CASE("Modify component", "[component]")
@@ -133,3 +178,1410 @@ TEST_CASE("No components", "[component]")
     }
     REQUIRE(sum == 0);
 }
+
+TEST_CASE("Component pool index", "[component]")
+{
+    ge::thing::internals::OneTypeComponents<int> pool;
+
+    auto e1 = ge::thing::Entity{1, 0};
+    auto e2 = ge::thing::Entity{5000, 0};
+    auto e3 = ge::thing::Entity{100000, 0};
+
+    pool.add(e1) = 1;
+    pool.add(e2) = 2;
+    pool.add(e3) = 3;
+
+    REQUIRE(pool.size() == 3);
+    REQUIRE(pool.contains(e2));
+    REQUIRE(!pool.contains(ge::thing::Entity{2, 0}));
+    REQUIRE(!pool.contains(ge::thing::Entity{1000000, 0}));
+    REQUIRE(!pool.contains(ge::thing::Entity{5000, 1}));
+    REQUIRE_THROWS_AS(
+        pool.component(ge::thing::Entity{2, 0}), std::out_of_range);
+
+    pool.killEntity(e1);
+
+    REQUIRE(pool.size() == 2);
+    REQUIRE(!pool.contains(e1));
+    REQUIRE(pool.component(e2) == 2);
+    REQUIRE(pool.component(e3) == 3);
+    REQUIRE(pool.entities()[0] == e3);
+
+    pool.killEntity(e3);
+    pool.killEntity(e3);
+
+    REQUIRE(pool.size() == 1);
+    REQUIRE(pool.component(e2) == 2);
+}
+
+TEST_CASE("Multi-component view", "[view]")
+{
+    ge::thing::EntityManager manager;
+
+    auto e1 = manager.createEntity();
+    auto e2 = manager.createEntity();
+    auto e3 = manager.createEntity();
+    auto e4 = manager.createEntity();
+
+    manager.add<C1>(e1).id = 1;
+    manager.add<C1>(e2).id = 2;
+    manager.add<C1>(e3).id = 3;
+    manager.add<C2>(e2).id = 20;
+    manager.add<C2>(e3).id = 30;
+    manager.add<C2>(e4).id = 40;
+    manager.add<int>(e3) = 300;
+
+    SECTION("Two components")
+    {
+        int sum = 0;
+        for (auto [entity, c1, c2] : manager.view<C1, C2>()) {
+            REQUIRE(entity != e1);
+            REQUIRE(entity != e4);
+            c2.id += c1.id;
+            sum += c2.id;
+        }
+        REQUIRE(sum == 55);
+        REQUIRE(manager.component<C2>(e2).id == 22);
+    }
+
+    SECTION("Smallest pool drives iteration")
+    {
+        auto view = manager.view<C1, C2, int>();
+        REQUIRE(view.sizeHint() == 1);
+
+        int count = 0;
+        view.each([&] (ge::thing::Entity entity, C1&, C2&, int& i) {
+            REQUIRE(entity == e3);
+            REQUIRE(i == 300);
+            ++count;
+        });
+        REQUIRE(count == 1);
+    }
+
+    SECTION("Const view")
+    {
+        const auto& constManager = manager;
+        int sum = 0;
+        for (auto [entity, c1, c2] : constManager.view<C1, C2>()) {
+            sum += c1.id + c2.id;
+        }
+        REQUIRE(sum == 55);
+    }
+
+    SECTION("Missing pool")
+    {
+        auto view = manager.view<C1, std::string>();
+        REQUIRE(view.begin() == view.end());
+    }
+}
+
+TEST_CASE("Change detection", "[view]")
+{
+    using ge::thing::Added;
+    using ge::thing::Changed;
+
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(1000);
+    for (auto entity : entities) {
+        manager.add<C1>(entity).id = static_cast<int>(entity.index());
+    }
+    manager.add<C2>(entities[0]);
+
+    auto count = [] (auto view) {
+        size_t count = 0;
+        for (auto&& tuple : view) {
+            (void)tuple;
+            ++count;
+        }
+        return count;
+    };
+
+    auto since = manager.advanceTick();
+    REQUIRE(manager.tick() == since + 1);
+    REQUIRE(count(manager.view<Changed<const C1>>()) == 1000);
+    REQUIRE(count(manager.view<Changed<const C1>>(since)) == 0);
+
+    SECTION("Mutable access marks changes")
+    {
+        manager.component<C1>(entities[10]).id = -1;
+        manager.component<C1>(entities[700]).id = -1;
+        manager.components<C1>()[500].id = -1;
+        manager.markChanged<C1>(entities[500]);
+
+        std::vector<int> changed;
+        const auto& constManager = manager;
+        for (auto [entity, c1] : constManager.view<Changed<C1>>(since)) {
+            static_assert(std::is_const_v<std::remove_reference_t<
+                decltype(c1)>>);
+            REQUIRE(c1.id == -1);
+            changed.push_back(static_cast<int>(entity.index()));
+        }
+        REQUIRE(changed == std::vector<int>{10, 500, 700});
+
+        // Iterating with mutable access marks everything it visits.
+        auto next = manager.advanceTick();
+        for (auto [entity, c1] : manager.view<C1>()) {
+            (void)c1;
+        }
+        REQUIRE(count(manager.view<Changed<const C1>>(next)) == 1000);
+    }
+
+    SECTION("Reads mark nothing")
+    {
+        for (auto [entity, c1] : manager.view<const C1>()) {
+            (void)c1;
+        }
+        for (auto [entity, c1] : manager.view<ge::thing::Read<C1>>()) {
+            static_assert(std::is_const_v<std::remove_reference_t<
+                decltype(c1)>>);
+        }
+        ge::thing::Query<ge::thing::Read<C1>> read{manager};
+        read.each([] (ge::thing::Entity, const C1&) {});
+        ge::thing::Query<const C1, ge::thing::Optional<const C2>> optional{
+            manager};
+        optional.each([] (ge::thing::Entity, const C1&, const C2*) {});
+        REQUIRE(count(manager.view<Changed<const C1>>(since)) == 0);
+        REQUIRE(count(manager.view<Changed<const C2>>(since)) == 0);
+
+        for (auto [entity, c1] : manager.view<ge::thing::Write<C1>>()) {
+            (void)c1;
+        }
+        REQUIRE(count(manager.view<Changed<const C1>>(since)) == 1000);
+    }
+
+    SECTION("Added")
+    {
+        manager.add<C2>(entities[3]);
+        manager.add<C2>(entities[0]);
+
+        auto added = manager.view<const C1, Added<const C2>>(since);
+        REQUIRE(added.sizeHint() == 2);
+        REQUIRE(count(added) == 1);
+        REQUIRE(count(manager.view<Changed<const C2>>(since)) == 2);
+    }
+
+    SECTION("Removal keeps ticks with components")
+    {
+        manager.component<C1>(entities.back()).id = -1;
+        manager.killEntity(entities[0]);
+
+        auto view = manager.view<Changed<const C1>>(since);
+        REQUIRE(count(view) == 1);
+        REQUIRE(std::get<0>(*view.begin()) == entities.back());
+    }
+
+    SECTION("Parallel")
+    {
+        for (size_t i = 0; i < entities.size(); i += 100) {
+            manager.component<C1>(entities[i]).id = -1;
+        }
+
+        ge::thing::ThreadPool pool{4};
+        std::atomic<int> changed = 0;
+        manager.view<Changed<const C1>>(since).parallelEach(
+            pool,
+            [&] (ge::thing::Entity, const C1& c1) {
+                if (c1.id == -1) {
+                    ++changed;
+                }
+            },
+            64);
+        REQUIRE(changed == 10);
+    }
+}
+
+TEST_CASE("Sort", "[component]")
+{
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(300);
+    for (auto entity : entities) {
+        auto index = static_cast<int>(entity.index());
+        manager.add<C1>(entity).id = (index * 37) % 300;
+        if (index % 2 == 0) {
+            manager.add<C2>(entity).id = index;
+        }
+    }
+
+    manager.sort<C1>([] (const C1& lhs, const C1& rhs) {
+        return lhs.id < rhs.id;
+    });
+    auto c1 = manager.components<C1>();
+    for (size_t i = 0; i < c1.size(); i++) {
+        REQUIRE(c1[i].id == static_cast<int>(i));
+    }
+    const auto& constManager = manager;
+    for (auto entity : entities) {
+        REQUIRE(constManager.component<C1>(entity).id ==
+            (static_cast<int>(entity.index()) * 37) % 300);
+    }
+
+    // Order C2 as C1, through entities.
+    std::vector<size_t> rank(entities.size());
+    auto sorted = manager.entities<C1>();
+    for (size_t i = 0; i < sorted.size(); i++) {
+        rank[sorted[i].index()] = i;
+    }
+    manager.sort<C2>([&] (ge::thing::Entity lhs, ge::thing::Entity rhs) {
+        return rank[lhs.index()] < rank[rhs.index()];
+    });
+    auto c2 = manager.entities<C2>();
+    for (size_t i = 1; i < c2.size(); i++) {
+        REQUIRE(rank[c2[i - 1].index()] < rank[c2[i].index()]);
+    }
+}
+
+TEST_CASE("Owning group", "[view]")
+{
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(100);
+    for (auto entity : entities) {
+        auto index = static_cast<int>(entity.index());
+        manager.add<C1>(entity).id = index;
+        if (index % 3 == 0) {
+            manager.add<C2>(entity).id = -index;
+        }
+    }
+
+    auto check = [&] (size_t expected) {
+        auto group = manager.group<C1, C2>();
+        REQUIRE(group.size() == expected);
+        auto c1 = group.components<C1>();
+        auto c2 = group.components<C2>();
+        auto shared = group.entities();
+        for (size_t i = 0; i < group.size(); i++) {
+            REQUIRE(c1[i].id == -c2[i].id);
+            REQUIRE(manager.entities<C1>()[i] == shared[i]);
+            REQUIRE(manager.entities<C2>()[i] == shared[i]);
+        }
+        size_t count = 0;
+        for (auto [entity, lhs, rhs] : group) {
+            REQUIRE(lhs.id == -rhs.id);
+            ++count;
+        }
+        REQUIRE(count == expected);
+    };
+
+    check(34);
+
+    manager.add<C2>(entities[1]).id = -1;
+    manager.remove<C2>(entities[0]);
+    manager.killEntity(entities[3]);
+    manager.remove<C1>(entities[6]);
+    check(32);
+
+    auto spawned = manager.spawn(entities[9], 10);
+    check(42);
+
+    REQUIRE_THROWS_AS((manager.group<C1, int>()), std::logic_error);
+    REQUIRE_THROWS_AS(
+        manager.sort<C1>([] (const C1&, const C1&) { return false; }),
+        std::logic_error);
+}
+
+TEST_CASE("Hierarchy", "[hierarchy]")
+{
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(10);
+    const auto& hierarchy = manager.hierarchy();
+
+    // 0 -> (1 -> (3, 4), 2 -> 5), 6 -> 7
+    manager.setParent(entities[1], entities[0]);
+    manager.setParent(entities[2], entities[0]);
+    manager.setParent(entities[3], entities[1]);
+    manager.setParent(entities[4], entities[1]);
+    manager.setParent(entities[5], entities[2]);
+    manager.setParent(entities[7], entities[6]);
+    REQUIRE(hierarchy.size() == 8);
+    REQUIRE(hierarchy.parent(entities[3]) == entities[1]);
+    REQUIRE(!hierarchy.parent(entities[0]));
+
+    auto indices = [] (auto nodes) {
+        std::vector<int> indices;
+        for (const auto& node : nodes) {
+            indices.push_back(static_cast<int>(node.entity.index()));
+        }
+        return indices;
+    };
+
+    auto breadthFirst = hierarchy.breadthFirst();
+    REQUIRE(indices(breadthFirst) == std::vector<int>{0, 6, 1, 2, 7, 3, 4, 5});
+    REQUIRE(indices(hierarchy.children(entities[1])) ==
+        std::vector<int>{3, 4});
+    for (const auto& node : breadthFirst) {
+        if (node.parent != ge::thing::BreadthFirstNode::NoParent) {
+            REQUIRE(hierarchy.parent(node.entity) ==
+                breadthFirst[node.parent].entity);
+        }
+    }
+
+    auto depthFirst = hierarchy.depthFirst();
+    REQUIRE(indices(depthFirst) == std::vector<int>{0, 1, 3, 4, 2, 5, 6, 7});
+    REQUIRE(depthFirst[0].subtreeEnd == 6);
+    REQUIRE(depthFirst[1].subtreeEnd == 4);
+    REQUIRE(depthFirst[6].subtreeEnd == 8);
+
+    REQUIRE_THROWS_AS(
+        manager.setParent(entities[0], entities[5]), std::invalid_argument);
+
+    SECTION("Reparent and kill")
+    {
+        manager.setParent(entities[2], entities[7]);
+        REQUIRE(indices(hierarchy.depthFirst()) ==
+            std::vector<int>{0, 1, 3, 4, 6, 7, 2, 5});
+
+        manager.killEntity(entities[1]);
+        manager.removeParent(entities[7]);
+        // Entities without relationships leave the hierarchy.
+        REQUIRE(!hierarchy.contains(entities[0]));
+        REQUIRE(!hierarchy.contains(entities[3]));
+        REQUIRE(!hierarchy.contains(entities[6]));
+        REQUIRE(indices(hierarchy.breadthFirst()) ==
+            std::vector<int>{7, 2, 5});
+        REQUIRE(hierarchy.size() == 3);
+    }
+
+    SECTION("Parallel")
+    {
+        // A chain of subtrees large enough to be split.
+        auto nodes = manager.createEntities(5000);
+        manager.setParent(nodes[0], entities[9]);
+        for (size_t i = 1; i < nodes.size(); i++) {
+            manager.setParent(nodes[i], nodes[(i - 1) / 4]);
+        }
+
+        auto order = hierarchy.depthFirst();
+        std::vector<int> depth(order.size(), -1);
+        ge::thing::ThreadPool pool{4};
+        hierarchy.parallelDepthFirst(
+            pool,
+            [&] (size_t position, const ge::thing::DepthFirstNode& node) {
+                auto parent = node.parent;
+                depth[position] =
+                    parent == ge::thing::DepthFirstNode::NoParent ?
+                        0 : depth[parent] + 1;
+            },
+            64);
+
+        for (size_t position = 0; position < order.size(); position++) {
+            REQUIRE(depth[position] >= 0);
+            if (order[position].parent !=
+                    ge::thing::DepthFirstNode::NoParent) {
+                REQUIRE(depth[position] == depth[order[position].parent] + 1);
+            }
+        }
+    }
+}
+
+TEST_CASE("Bulk creation", "[entities]")
+{
+    ge::thing::EntityManager manager;
+
+    auto first = manager.createEntities(3);
+    manager.killEntity(first[1]);
+
+    auto entities = manager.createEntities(1000);
+    REQUIRE(entities.size() == 1000);
+    REQUIRE(entities[0].index() == first[1].index());
+    REQUIRE(entities[0].generation() == 1);
+    for (auto entity : entities) {
+        REQUIRE(manager.alive(entity));
+    }
+
+    std::vector<C1> values;
+    for (int i = 0; i < 1000; i++) {
+        values.push_back(C1{i});
+    }
+    manager.addBatch<C1>(entities, values);
+    manager.addBatch<C2>(entities, C2{7});
+
+    REQUIRE(manager.components<C1>().size() == 1000);
+    REQUIRE(manager.component<C1>(entities[10]).id == 10);
+    REQUIRE(manager.component<C2>(entities[999]).id == 7);
+
+    std::vector<C1> tooFew(10);
+    REQUIRE_THROWS_AS(
+        manager.addBatch<C1>(entities, tooFew), std::invalid_argument);
+}
+
+TEST_CASE("Repeated small batches", "[entities]")
+{
+    ge::thing::EntityManager manager;
+
+    auto prototype = manager.createEntity();
+    manager.add<C1>(prototype).id = 1;
+
+    // Capacity grows geometrically across batches, instead of to the exact
+    // size of each one.
+    size_t poolGrowths = 0;
+    size_t slotGrowths = 0;
+    for (int frame = 0; frame < 200; frame++) {
+        auto capacity = manager.statistics<C1>().capacity;
+        auto slotBytes = manager.statistics().entityBytes;
+        auto entities = manager.createEntities(50);
+        manager.addBatch<C2>(entities, C2{frame});
+        manager.spawn(prototype, 50);
+        poolGrowths += manager.statistics<C1>().capacity != capacity;
+        slotGrowths += manager.statistics().entityBytes != slotBytes;
+    }
+    REQUIRE(manager.components<C1>().size() == 10001);
+    REQUIRE(manager.components<C2>().size() == 10000);
+    REQUIRE(poolGrowths < 20);
+    REQUIRE(slotGrowths < 40);
+    REQUIRE(manager.statistics<C2>().capacity < 2 * 10000);
+}
+
+TEST_CASE("Spawn from prototype", "[entities]")
+{
+    ge::thing::EntityManager manager;
+
+    auto prototype = manager.createEntity();
+    manager.add<C1>(prototype).id = 1;
+    manager.add<std::string>(prototype) = "projectile";
+
+    auto other = manager.createEntity();
+    manager.add<C2>(other).id = 2;
+
+    auto projectiles = manager.spawn(prototype, 50);
+
+    REQUIRE(projectiles.size() == 50);
+    REQUIRE(manager.components<C1>().size() == 51);
+    REQUIRE(manager.components<std::string>().size() == 51);
+    REQUIRE(manager.components<C2>().size() == 1);
+    for (auto projectile : projectiles) {
+        REQUIRE(manager.component<C1>(projectile).id == 1);
+        REQUIRE(manager.component<std::string>(projectile) == "projectile");
+        REQUIRE(!manager.has<C2>(projectile));
+    }
+}
+
+namespace {
+
+struct Frozen {};
+
+struct Settings {
+    using Storage = ge::thing::storage::Singleton;
+    int difficulty;
+};
+
+struct Big {
+    using Storage = ge::thing::storage::Paged;
+    int values[256];
+};
+
+struct Particle {
+    using Storage = ge::thing::storage::Columns;
+    float x, y, vx, vy;
+    static constexpr auto fields = std::tuple{
+        &Particle::x, &Particle::y, &Particle::vx, &Particle::vy};
+};
+
+} // namespace
+
+TEST_CASE("Storage policies", "[storage]")
+{
+    static_assert(std::is_same_v<
+        ge::thing::StoragePolicy<Frozen>, ge::thing::storage::Tag>);
+    static_assert(std::is_same_v<
+        ge::thing::StoragePolicy<C1>, ge::thing::storage::Dense>);
+
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(100);
+
+    SECTION("Tag")
+    {
+        for (auto entity : entities) {
+            if (entity.index() % 2 == 0) {
+                manager.add<Frozen>(entity);
+            }
+            manager.add<C1>(entity).id = static_cast<int>(entity.index());
+        }
+        manager.remove<Frozen>(entities[0]);
+
+        REQUIRE(manager.entities<Frozen>().size() == 49);
+        REQUIRE(manager.has<Frozen>(entities[2]));
+        REQUIRE(!manager.has<Frozen>(entities[0]));
+
+        int count = 0;
+        for (auto [entity, c1, frozen] : manager.view<C1, Frozen>()) {
+            REQUIRE(c1.id % 2 == 0);
+            ++count;
+        }
+        REQUIRE(count == 49);
+
+        // Tags cannot change; only adding one counts.
+        auto since = manager.advanceTick();
+        manager.markChanged<Frozen>(entities[2]);
+        manager.add<Frozen>(entities[0]);
+        std::vector<ge::thing::Entity> changed;
+        for (auto [entity, frozen] :
+                manager.view<ge::thing::Changed<const Frozen>>(since)) {
+            changed.push_back(entity);
+        }
+        REQUIRE(changed == std::vector{entities[0]});
+    }
+
+    SECTION("Singleton")
+    {
+        REQUIRE_THROWS_AS(manager.singleton<Settings>(), std::out_of_range);
+
+        manager.add<Settings>(entities[5]).difficulty = 3;
+        REQUIRE(manager.singleton<Settings>().difficulty == 3);
+        REQUIRE(manager.has<Settings>(entities[5]));
+        REQUIRE(!manager.has<Settings>(entities[6]));
+        REQUIRE_THROWS_AS(
+            manager.add<Settings>(entities[6]), std::logic_error);
+
+        manager.killEntity(entities[5]);
+        REQUIRE_THROWS_AS(manager.singleton<Settings>(), std::out_of_range);
+        manager.add<Settings>(entities[6]).difficulty = 4;
+        REQUIRE(manager.component<Settings>(entities[6]).difficulty == 4);
+    }
+
+    SECTION("Paged")
+    {
+        std::vector<Big*> addresses;
+        for (auto entity : entities) {
+            auto& big = manager.add<Big>(entity);
+            big.values[0] = static_cast<int>(entity.index());
+            addresses.push_back(&big);
+        }
+        for (size_t i = 0; i < entities.size(); i += 3) {
+            manager.killEntity(entities[i]);
+        }
+
+        for (size_t i = 0; i < entities.size(); i++) {
+            if (i % 3 != 0) {
+                auto& big = manager.component<Big>(entities[i]);
+                REQUIRE(&big == addresses[i]);
+                REQUIRE(big.values[0] == static_cast<int>(i));
+            }
+        }
+
+        int count = 0;
+        for (auto [entity, big] : manager.view<Big>()) {
+            REQUIRE(big.values[0] == static_cast<int>(entity.index()));
+            ++count;
+        }
+        REQUIRE(count == 66);
+    }
+
+    SECTION("Columns")
+    {
+        for (auto entity : entities) {
+            auto value = static_cast<float>(entity.index());
+            manager.add<Particle>(entity, Particle{value, 0, 1, value});
+        }
+        for (size_t i = 0; i < entities.size(); i += 4) {
+            manager.killEntity(entities[i]);
+        }
+
+        auto xs = manager.column<&Particle::x>();
+        auto vys = std::as_const(manager).column<&Particle::vy>();
+        REQUIRE(xs.size() == 75);
+        REQUIRE(vys.size() == 75);
+        auto owners = manager.entities<Particle>();
+        for (size_t i = 0; i < owners.size(); i++) {
+            REQUIRE(xs[i] == static_cast<float>(owners[i].index()));
+            REQUIRE(vys[i] == xs[i]);
+        }
+
+        auto particle = manager.component<Particle>(entities[5]);
+        REQUIRE(particle.get<&Particle::vx>() == 1);
+        particle.get<&Particle::y>() = 2;
+        particle = Particle{6, 7, 8, 9};
+        Particle copy = std::as_const(manager).component<Particle>(
+            entities[5]);
+        REQUIRE(copy.x == 6);
+        REQUIRE(copy.vy == 9);
+
+        for (auto [entity, p] : manager.view<Particle>()) {
+            p.get<&Particle::x>() += p.get<&Particle::vx>();
+        }
+        REQUIRE(manager.component<Particle>(entities[5]).get<&Particle::x>()
+            == 14);
+        REQUIRE(manager.component<Particle>(entities[7]).get<&Particle::x>()
+            == 8);
+
+        std::vector<Particle> removed;
+        auto hook = manager.onRemove<Particle>(
+            [&removed] (ge::thing::Entity, const Particle& p) {
+                removed.push_back(p);
+            });
+        manager.remove<Particle>(entities[7]);
+        manager.removeHook<Particle>(hook);
+        REQUIRE(removed.size() == 1);
+        REQUIRE(removed[0].vy == 7);
+        REQUIRE(manager.column<&Particle::vx>().size() == 74);
+
+        std::stringstream stream;
+        manager.save<Particle>(stream);
+        auto snapshot = stream.str();
+        ge::thing::EntityManager loaded;
+        loaded.load<Particle>(std::as_bytes(std::span{snapshot}));
+        REQUIRE(loaded.component<Particle>(entities[5]).get<&Particle::vy>()
+            == 9);
+        REQUIRE(loaded.column<&Particle::y>().size() == 74);
+    }
+}
+
+namespace {
+
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocated = 0;
+    size_t allocations = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocated += bytes;
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        allocated -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+} // namespace
+
+TEST_CASE("Memory", "[storage]")
+{
+    CountingResource resource;
+    {
+        ge::thing::EntityManager manager{&resource};
+        auto entities = manager.createEntities(1000);
+        for (auto entity : entities) {
+            manager.add<C1>(entity);
+            manager.add<Big>(entity);
+        }
+        manager.add<Frozen>(entities[0]);
+        for (size_t i = 0; i < 500; i++) {
+            manager.killEntity(entities[i]);
+        }
+
+        auto statistics = manager.statistics();
+        REQUIRE(statistics.entitySlots == 1000);
+        REQUIRE(statistics.liveEntities == 500);
+        REQUIRE(statistics.pools.size() == 3);
+        REQUIRE(statistics.totalBytes() <= resource.allocated);
+        REQUIRE(statistics.totalBytes() > resource.allocated / 2);
+
+        auto c1 = manager.statistics<C1>();
+        REQUIRE(c1.component == ge::thing::componentId<C1>());
+        REQUIRE(c1.size == 500);
+        REQUIRE(c1.capacity >= 1000);
+        REQUIRE(c1.componentBytes == c1.capacity * sizeof(C1));
+        REQUIRE(c1.indexBytes > 0);
+        REQUIRE(c1.fragmentation > 0.4);
+        REQUIRE(c1.fragmentation < 1);
+
+        auto frozen = manager.statistics<Frozen>();
+        REQUIRE(frozen.size == 0);
+        REQUIRE(frozen.componentBytes == 0);
+        REQUIRE(manager.statistics<C2>().size == 0);
+    }
+    REQUIRE(resource.allocated == 0);
+
+    std::pmr::monotonic_buffer_resource arena;
+    ge::thing::EntityManager manager{&arena};
+    for (auto entity : manager.createEntities(100)) {
+        manager.add<Big>(entity);
+    }
+    REQUIRE(manager.statistics<Big>().size == 100);
+}
+
+TEST_CASE("Compaction", "[storage]")
+{
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(10000);
+    // Add in reverse, then kill every other entity.
+    for (auto entity = entities.rbegin(); entity != entities.rend();
+            ++entity) {
+        manager.add<C1>(*entity, C1{static_cast<int>(entity->index())});
+        manager.add<Big>(*entity);
+    }
+    for (size_t i = 0; i < entities.size(); i += 2) {
+        manager.killEntity(entities[i]);
+    }
+    auto capacity = manager.statistics<C1>().capacity;
+
+    auto requireOrdered = [&] {
+        auto pool = manager.entities<C1>();
+        REQUIRE(pool.size() == entities.size() / 2);
+        for (size_t i = 1; i < pool.size(); i++) {
+            REQUIRE(pool[i - 1].index() < pool[i].index());
+        }
+        for (auto entity : pool) {
+            REQUIRE(std::as_const(manager).component<C1>(entity).id ==
+                static_cast<int>(entity.index()));
+        }
+    };
+
+    SECTION("Whole pass")
+    {
+        manager.compact();
+        requireOrdered();
+        REQUIRE(manager.statistics<C1>().capacity < capacity);
+        REQUIRE(manager.statistics<C1>().fragmentation < 0.5);
+
+        // New entities take the lowest free slots first.
+        REQUIRE(manager.createEntity().index() == 0);
+        REQUIRE(manager.createEntity().index() == 2);
+    }
+
+    SECTION("Incremental")
+    {
+        size_t steps = 1;
+        while (!manager.compact(std::chrono::steady_clock::duration{0})) {
+            ++steps;
+            // Changes between steps keep the pools valid.
+            if (steps == 5) {
+                manager.killEntity(entities[1]);
+                auto revived = manager.createEntity(ge::thing::Entity{
+                    0, entities[0].generation() + 1});
+                manager.add<C1>(revived, C1{0});
+            }
+        }
+        REQUIRE(steps > 5);
+        manager.compact();
+        requireOrdered();
+    }
+
+    SECTION("Grouped pools keep their order")
+    {
+        auto group = manager.group<C1, Big>();
+        manager.compact();
+        REQUIRE(group.size() == entities.size() / 2);
+        for (auto [entity, c1, big] : group) {
+            REQUIRE(c1.id == static_cast<int>(entity.index()));
+        }
+    }
+}
+
+TEST_CASE("Compaction steps", "[storage]")
+{
+    CountingResource resource;
+    ge::thing::EntityManager manager{&resource};
+    auto entities = manager.createEntities(10000);
+    for (auto entity = entities.rbegin(); entity != entities.rend();
+            ++entity) {
+        manager.add<C1>(*entity, C1{static_cast<int>(entity->index())});
+        manager.add<C2>(*entity);
+    }
+    for (size_t i = 0; i < entities.size(); i += 2) {
+        manager.killEntity(entities[i]);
+    }
+
+    SECTION("Each step reallocates at most one array")
+    {
+        size_t steps = 0;
+        for (bool done = false; !done; steps++) {
+            auto allocations = resource.allocations;
+            done = manager.compact(std::chrono::steady_clock::duration{0});
+            REQUIRE(resource.allocations - allocations <= 1);
+        }
+        // Relinking the entity slots alone takes several steps.
+        REQUIRE(steps > 20);
+        REQUIRE(manager.statistics<C1>().fragmentation < 0.5);
+        REQUIRE(manager.statistics().entityBytes ==
+            entities.size() * sizeof(ge::thing::Entity));
+    }
+}
+
+TEST_CASE("Entity slot relink", "[entities]")
+{
+    using ge::thing::Entity;
+
+    ge::thing::internals::EntityPool pool;
+    std::vector<Entity> entities(100, Entity{0, 0});
+    pool.createEntities(entities);
+    for (size_t i = 0; i < entities.size(); i += 2) {
+        pool.killEntity(entities[i]);
+    }
+    auto revive = [&entities] (size_t index) {
+        return Entity{
+            static_cast<Entity::IndexType>(index),
+            entities[index].generation() + 1};
+    };
+
+    // Slots below 50 are relinked; dead ones past them are on no list.
+    size_t budget = 50;
+    REQUIRE(!pool.compact(budget));
+    REQUIRE(budget == 0);
+
+    pool.killEntity(entities[1]);
+    pool.killEntity(entities[71]);
+    REQUIRE(pool.createEntity(revive(60)) == revive(60));
+    REQUIRE(pool.createEntity(revive(48)) == revive(48));
+    REQUIRE(pool.createEntity().index() == 1);
+
+    std::ostringstream stream;
+    ge::thing::internals::BlobWriter writer{stream};
+    pool.save(writer);
+    auto snapshot = stream.str();
+    ge::thing::internals::BlobReader reader{
+        std::as_bytes(std::span{snapshot})};
+    ge::thing::internals::EntityPool loaded;
+    loaded.load(reader);
+    REQUIRE(loaded.createEntity().index() == 0);
+
+    budget = 1000;
+    REQUIRE(pool.compact(budget));
+    std::vector<Entity::IndexType> free;
+    for (size_t i = 0; i < 47; i += 2) {
+        free.push_back(static_cast<Entity::IndexType>(i));
+    }
+    for (size_t i = 50; i < 100; i += 2) {
+        if (i == 60) {
+            continue;
+        }
+        free.push_back(static_cast<Entity::IndexType>(i));
+        if (i == 70) {
+            free.push_back(71);
+        }
+    }
+    for (auto index : free) {
+        REQUIRE(pool.createEntity().index() == index);
+    }
+    REQUIRE(pool.createEntity().index() == 100);
+}
+
+TEST_CASE("Concurrent access", "[threads]")
+{
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(1000);
+    for (auto entity : entities) {
+        manager.add<C1>(entity, C1{1});
+    }
+
+    // Catch assertions are not thread-safe; readers count their failures.
+    std::atomic<int> failures = 0;
+    auto read = [&manager, &failures] {
+        for (int i = 0; i < 100; i++) {
+            auto access = manager.readAccess<C1>();
+            int sum = 0;
+            for (auto [entity, c1] : access.view<C1>()) {
+                sum += c1.id;
+            }
+            if (sum != 1000 ||
+                    access.entities<C1>().size() != 1000 ||
+                    !access.has<C1>(access.entities<C1>()[0])) {
+                ++failures;
+            }
+        }
+    };
+
+    SECTION("Writer of another pool")
+    {
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; i++) {
+            readers.emplace_back(read);
+        }
+        for (int i = 0; i < 10; i++) {
+            auto access = manager.writeAccess<C2>();
+            for (auto entity : entities) {
+                if (access.has<C2>(entity)) {
+                    access.component<C2>(entity).id++;
+                } else {
+                    access.add<C2>(entity, C2{0});
+                }
+            }
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        REQUIRE(failures == 0);
+        REQUIRE(manager.component<C2>(entities[0]).id == 9);
+    }
+
+    SECTION("Structural changes")
+    {
+        std::thread reader{read};
+        for (size_t i = 0; i < 100; i++) {
+            auto lock = manager.lockStructure();
+            manager.killEntity(entities[i]);
+            manager.add<C1>(manager.createEntity(), C1{1});
+        }
+        reader.join();
+        REQUIRE(failures == 0);
+        REQUIRE(manager.entities<C1>().size() == 1000);
+    }
+
+    SECTION("Waiting writer")
+    {
+        std::atomic<bool> changed = false;
+        std::thread writer;
+        std::thread reader;
+        {
+            auto first = manager.readAccess<C1>();
+            REQUIRE_THROWS_AS(manager.lockStructure(), std::logic_error);
+            writer = std::thread{[&manager, &entities, &changed] {
+                auto lock = manager.lockStructure();
+                manager.killEntity(entities[0]);
+                changed = true;
+            }};
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            // New tokens wait for the writer.
+            reader = std::thread{[&manager, &changed, &failures] {
+                auto access = manager.readAccess<C1>();
+                if (!changed) {
+                    ++failures;
+                }
+            }};
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            REQUIRE(!changed);
+        }
+        writer.join();
+        reader.join();
+        REQUIRE(failures == 0);
+        REQUIRE(!manager.alive(entities[0]));
+    }
+
+    SECTION("One token per thread")
+    {
+        // Taking Position then Velocity here and Velocity then Position on
+        // another thread could deadlock on the pools.
+        ge::thing::EntityManager other;
+        {
+            auto first = manager.writeAccess<C1>();
+            REQUIRE_THROWS_AS(manager.writeAccess<C2>(), std::logic_error);
+            REQUIRE_THROWS_AS(manager.readAccess<C2>(), std::logic_error);
+            REQUIRE_THROWS_AS(other.readAccess<C1>(), std::logic_error);
+            REQUIRE_THROWS_AS(other.lockStructure(), std::logic_error);
+        }
+        {
+            // Reading two managers takes one token after the other.
+            auto first = other.readAccess<C1>();
+            REQUIRE(first.entities<C1>().empty());
+        }
+        {
+            auto lock = other.lockStructure();
+        }
+        {
+            auto first = manager.readAccess<C1>();
+            REQUIRE_THROWS_AS(manager.readAccess<C1>(), std::logic_error);
+        }
+        auto second = manager.writeAccess<C1, C2>();
+        REQUIRE(second.component<C1>(entities[0]).id == 1);
+    }
+
+    SECTION("Hooked pools")
+    {
+        // The query hooks both pools: adding through tokens on two threads
+        // would update its matches concurrently.
+        ge::thing::Query<C1, ge::thing::Without<C2>> query{manager};
+        auto others = manager.createEntities(100);
+        std::atomic<int> rejected = 0;
+        auto add = [&manager, &rejected] <class Component> (
+                std::span<const ge::thing::Entity> targets) {
+            auto access = manager.writeAccess<Component>();
+            for (auto entity : targets) {
+                try {
+                    access.template add<Component>(entity, Component{2});
+                } catch (const std::logic_error&) {
+                    ++rejected;
+                }
+            }
+        };
+        std::thread first{[&add, &others] {
+            add.template operator()<C1>(others);
+        }};
+        std::thread second{[&add, &entities] {
+            add.template operator()<C2>(std::span{entities}.first(100));
+        }};
+        first.join();
+        second.join();
+        REQUIRE(rejected == 200);
+        REQUIRE(query.size() == 1000);
+        REQUIRE(manager.entities<C2>().empty());
+
+        // Writes to existing components are not events.
+        {
+            auto access = manager.writeAccess<C1>();
+            access.component<C1>(entities[0]).id = 3;
+        }
+        manager.add<C2>(entities[0], C2{2});
+        REQUIRE(query.size() == 999);
+    }
+
+    SECTION("Errors")
+    {
+        manager.killEntity(entities[0]);
+        manager.group<C1, C2>();
+        auto access = manager.writeAccess<C1, C2>();
+        REQUIRE_THROWS_AS(
+            access.add<C2>(entities[0], C2{}), std::invalid_argument);
+        REQUIRE_THROWS_AS(
+            access.add<C2>(entities[1], C2{}), std::logic_error);
+        REQUIRE(access.component<C1>(entities[1]).id == 1);
+    }
+}
+
+TEST_CASE("Hooks", "[hooks]")
+{
+    using ge::thing::ComponentEvent;
+    using ge::thing::Entity;
+
+    ge::thing::EntityManager manager;
+    std::vector<std::pair<ComponentEvent, int>> events;
+    auto record = [&events] (ComponentEvent event) {
+        return [&events, event] (Entity, const C1& c1) {
+            events.emplace_back(event, c1.id);
+        };
+    };
+    auto added = manager.onAdd<C1>(record(ComponentEvent::Added));
+    manager.onReplace<C1>(record(ComponentEvent::Replaced));
+    manager.onRemove<C1>(record(ComponentEvent::Removed));
+
+    auto e1 = manager.createEntity();
+    auto e2 = manager.createEntity();
+    manager.add<C1>(e1, C1{1});
+    manager.add<C1>(e2, C1{2});
+    manager.add<C1>(e1, C1{3});
+    // Writes through references are not events.
+    manager.component<C1>(e2).id = 4;
+    manager.remove<C1>(e2);
+    manager.killEntity(e1);
+    REQUIRE(events == std::vector<std::pair<ComponentEvent, int>>{
+        {ComponentEvent::Added, 1},
+        {ComponentEvent::Added, 2},
+        {ComponentEvent::Replaced, 3},
+        {ComponentEvent::Removed, 4},
+        {ComponentEvent::Removed, 3},
+    });
+
+    SECTION("Removal")
+    {
+        events.clear();
+        manager.removeHook<C1>(added);
+        manager.add<C1>(manager.createEntity(), C1{5});
+        REQUIRE(events.empty());
+    }
+
+    SECTION("Batches and prototypes")
+    {
+        events.clear();
+        auto entities = manager.createEntities(3);
+        manager.addBatch<C1>(entities, C1{6});
+        manager.spawn(entities[0], 2);
+        REQUIRE(events.size() == 5);
+    }
+
+    SECTION("Snapshots keep hooks")
+    {
+        std::stringstream stream;
+        manager.save<C1>(stream);
+        auto snapshot = stream.str();
+        manager.load<C1>(std::as_bytes(std::span{snapshot}));
+
+        events.clear();
+        manager.add<C1>(manager.createEntity(), C1{7});
+        REQUIRE(events.size() == 1);
+    }
+}
+
+TEST_CASE("Collector", "[hooks]")
+{
+    using ge::thing::ComponentEvent;
+
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(4);
+    ge::thing::Collector<C1> collector{
+        manager, {ComponentEvent::Added, ComponentEvent::Replaced}};
+    ge::thing::Collector<C1> removed{manager, {ComponentEvent::Removed}};
+
+    manager.add<C1>(entities[0], C1{0});
+    manager.add<C1>(entities[1], C1{1});
+    manager.add<C1>(entities[0], C1{2});
+    REQUIRE(collector.size() == 2);
+    REQUIRE(collector.contains(entities[0]));
+    REQUIRE(collector.contains(entities[1]));
+
+    // Entities that lost the component leave the collection.
+    manager.killEntity(entities[0]);
+    REQUIRE(collector.size() == 1);
+    REQUIRE(collector.entities()[0] == entities[1]);
+    REQUIRE(removed.size() == 1);
+    REQUIRE(removed.contains(entities[0]));
+
+    collector.clear();
+    removed.clear();
+    REQUIRE(collector.empty());
+    manager.add<C1>(entities[2], C1{3});
+    REQUIRE(collector.size() == 1);
+    REQUIRE(removed.empty());
+
+    {
+        ge::thing::Collector<C1> scoped{manager, {ComponentEvent::Added}};
+    }
+    manager.add<C1>(entities[3], C1{4});
+    REQUIRE(collector.size() == 2);
+}
+
+TEST_CASE("Query", "[query]")
+{
+    using ge::thing::Optional;
+    using ge::thing::Without;
+
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(6);
+    for (size_t i = 0; i < entities.size(); i++) {
+        manager.add<C1>(entities[i], C1{static_cast<int>(i)});
+    }
+    manager.add<Frozen>(entities[1]);
+    manager.add<C2>(entities[2], C2{20});
+
+    ge::thing::Query<C1, Without<Frozen>, Optional<const C2>> query{manager};
+    auto matches = [&query] {
+        std::vector<int> ids;
+        for (auto [entity, c1, c2] : query) {
+            ids.push_back(c1.id + (c2 ? c2->id : 0));
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+    REQUIRE(matches() == std::vector<int>{0, 3, 4, 5, 22});
+
+    manager.add<Frozen>(entities[3]);
+    manager.remove<Frozen>(entities[1]);
+    manager.remove<C1>(entities[4]);
+    manager.killEntity(entities[5]);
+    manager.add<C2>(entities[0], C2{10});
+    REQUIRE(matches() == std::vector<int>{1, 10, 22});
+    REQUIRE(query.contains(entities[1]));
+    REQUIRE_FALSE(query.contains(entities[3]));
+
+    auto entity = manager.createEntity();
+    manager.add<Frozen>(entity);
+    manager.add<C1>(entity, C1{7});
+    REQUIRE(query.size() == 3);
+
+    SECTION("Mutable terms")
+    {
+        auto since = manager.advanceTick();
+        ge::thing::Query<C1> all{manager};
+        all.each([] (ge::thing::Entity, C1& c1) {
+            c1.id *= 2;
+        });
+        REQUIRE(manager.view<ge::thing::Changed<C1>>(since).begin() !=
+            manager.view<ge::thing::Changed<C1>>(since).end());
+    }
+
+    SECTION("Rebuild after load")
+    {
+        std::stringstream stream;
+        manager.save<C1, Frozen>(stream);
+        auto snapshot = stream.str();
+        manager.load<C1, Frozen>(std::as_bytes(std::span{snapshot}));
+        query.rebuild();
+        REQUIRE(query.size() == 3);
+    }
+}
+
+TEST_CASE("Gather", "[component]")
+{
+    using ge::thing::GatherOrder;
+
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(1000);
+    for (auto entity : entities) {
+        auto index = static_cast<int>(entity.index());
+        manager.add<C1>(entity).id = index;
+        manager.add<Big>(entity).values[0] = index;
+        auto value = static_cast<float>(index);
+        manager.add<Particle>(entity, Particle{value, 0, 0, 0});
+    }
+    manager.add<Settings>(entities[3]).difficulty = 3;
+    manager.sort<C1>([] (const C1& lhs, const C1& rhs) {
+        return lhs.id > rhs.id;
+    });
+
+    std::vector<ge::thing::Entity> targets;
+    for (size_t i = 0; i < entities.size(); i += 7) {
+        targets.push_back(entities[(i * 31) % entities.size()]);
+    }
+    auto expected = [&targets] (size_t i) {
+        return static_cast<int>(targets[i].index());
+    };
+
+    for (auto order : {GatherOrder::Input, GatherOrder::Dense}) {
+        std::vector<C1> c1s(targets.size());
+        manager.gather<C1>(targets, c1s, order);
+        std::vector<Big> bigs(targets.size());
+        manager.gather<Big>(targets, bigs, order);
+        std::vector<Particle> particles(targets.size());
+        manager.gather<Particle>(targets, particles, order);
+        for (size_t i = 0; i < targets.size(); i++) {
+            REQUIRE(c1s[i].id == expected(i));
+            REQUIRE(bigs[i].values[0] == expected(i));
+            REQUIRE(particles[i].x == static_cast<float>(expected(i)));
+        }
+    }
+
+    std::vector<Settings> settings(1);
+    manager.gather<Settings>(std::span{&entities[3], 1}, settings);
+    REQUIRE(settings[0].difficulty == 3);
+
+    std::vector<C1> out(targets.size());
+    for (auto order : {GatherOrder::Input, GatherOrder::Dense}) {
+        REQUIRE_THROWS_AS(
+            manager.gather<C1>(std::span{targets}.first(3), out, order),
+            std::invalid_argument);
+        REQUIRE_THROWS_AS(
+            manager.gather<C1>(
+                targets, std::span{out}.first(targets.size() - 1), order),
+            std::invalid_argument);
+    }
+    manager.remove<C1>(targets[20]);
+    for (auto order : {GatherOrder::Input, GatherOrder::Dense}) {
+        REQUIRE_THROWS_AS(
+            manager.gather<C1>(targets, out, order), std::out_of_range);
+    }
+    std::vector<C2> c2s(targets.size());
+    REQUIRE_THROWS_AS(
+        manager.gather<C2>(targets, c2s), std::out_of_range);
+}
+
+TEST_CASE("Worlds", "[entities]")
+{
+    ge::thing::EntityManager manager;
+    auto entities = manager.createEntities(100);
+    for (auto entity : entities) {
+        auto index = static_cast<int>(entity.index());
+        manager.add<C1>(entity).id = index;
+        if (index % 2 == 0) {
+            manager.add<C2>(entity).id = -index;
+            manager.add<Big>(entity).values[0] = index;
+            manager.add<Particle>(entity, Particle{0, 0, 0, 0});
+        }
+    }
+    manager.group<C1, C2>();
+    manager.setParent(entities[1], entities[0]);
+    manager.killEntity(entities[99]);
+    manager.advanceTick();
+
+    SECTION("Clone")
+    {
+        int removed = 0;
+        manager.onRemove<C1>([&removed] (ge::thing::Entity, const C1&) {
+            ++removed;
+        });
+
+        auto copy = manager.clone();
+        REQUIRE(copy.tick() == manager.tick());
+        REQUIRE(!copy.alive(entities[99]));
+        REQUIRE(copy.hierarchy().parent(entities[1]) == entities[0]);
+        REQUIRE(copy.entities<C1>().size() == 99);
+        REQUIRE(std::ranges::equal(
+            copy.entities<C2>(), manager.entities<C2>()));
+        REQUIRE(copy.group<C1, C2>().size() == 50);
+        REQUIRE(copy.component<Big>(entities[4]).values[0] == 4);
+        REQUIRE(copy.column<&Particle::x>().size() == 50);
+
+        copy.component<C1>(entities[2]).id = 1000;
+        copy.killEntity(entities[4]);
+        copy.add<C2>(entities[5]).id = -5;
+        REQUIRE(copy.group<C1, C2>().size() == 50);
+        REQUIRE(removed == 0);
+        REQUIRE(manager.component<C1>(entities[2]).id == 2);
+        REQUIRE(manager.alive(entities[4]));
+        REQUIRE(!manager.has<C2>(entities[5]));
+
+        auto reused = copy.createEntity();
+        REQUIRE(reused.index() == 4);
+    }
+
+    SECTION("Move")
+    {
+        static_assert(
+            std::is_nothrow_move_constructible_v<ge::thing::EntityManager>);
+        static_assert(
+            std::is_nothrow_move_assignable_v<ge::thing::EntityManager>);
+        auto reserved = manager.reserveEntity();
+        auto group = manager.group<C1, C2>();
+        auto c1 = &manager.component<C1>(entities[2]);
+
+        std::vector<ge::thing::EntityManager> worlds;
+        worlds.push_back(std::move(manager));
+        worlds.emplace_back();
+        auto& moved = worlds[0];
+        REQUIRE(&moved.component<C1>(entities[2]) == c1);
+        REQUIRE(group.size() == 50);
+        REQUIRE(moved.entities<C1>().size() == 99);
+        REQUIRE(moved.hierarchy().parent(entities[1]) == entities[0]);
+        moved.flushReserved();
+        REQUIRE(moved.alive(reserved));
+        REQUIRE(moved.createEntity().index() == 99);
+
+        manager = std::move(worlds[0]);
+        REQUIRE(manager.component<C2>(entities[4]).id == -4);
+        REQUIRE(manager.alive(reserved));
+    }
+
+    SECTION("Migrate")
+    {
+        ge::thing::EntityManager target;
+        auto kept = target.createEntity();
+        target.add<C1>(kept).id = -1;
+        std::vector<int> added;
+        target.onAdd<C1>([&added] (ge::thing::Entity, const C1& c1) {
+            added.push_back(c1.id);
+        });
+
+        std::vector<ge::thing::Entity> chunk{
+            entities[0], entities[1], entities[2], entities[3]};
+        auto migrated = manager.migrate(chunk, target);
+        REQUIRE(migrated.size() == 4);
+        REQUIRE(added == std::vector<int>{0, 1, 2, 3});
+        for (size_t i = 0; i < chunk.size(); i++) {
+            REQUIRE(!manager.alive(chunk[i]));
+            REQUIRE(target.component<C1>(migrated[i]).id ==
+                static_cast<int>(i));
+        }
+        REQUIRE(target.component<C2>(migrated[2]).id == -2);
+        REQUIRE(target.component<Big>(migrated[0]).values[0] == 0);
+        REQUIRE(target.has<Particle>(migrated[2]));
+        REQUIRE(!target.has<C2>(migrated[1]));
+        REQUIRE(manager.entities<C1>().size() == 95);
+        REQUIRE(manager.group<C1, C2>().size() == 48);
+        REQUIRE(!manager.hierarchy().parent(entities[1]));
+
+        auto back = target.migrate(migrated, manager);
+        REQUIRE(target.entities<C1>().size() == 1);
+        REQUIRE(manager.component<C2>(back[0]).id == 0);
+        REQUIRE(manager.group<C1, C2>().size() == 50);
+
+        REQUIRE_THROWS_AS(
+            manager.migrate(chunk, target), std::invalid_argument);
+        REQUIRE_THROWS_AS(
+            manager.migrate(back, manager), std::invalid_argument);
+
+        std::vector<ge::thing::Entity> twice{back[0], back[1], back[0]};
+        auto targetLive = target.statistics().liveEntities;
+        REQUIRE_THROWS_AS(
+            manager.migrate(twice, target), std::invalid_argument);
+        REQUIRE(manager.component<C1>(back[0]).id == 0);
+        REQUIRE(target.statistics().liveEntities == targetLive);
+    }
+}
+
+TEST_CASE("Component IDs", "[component]")
+{
+    auto c1 = ge::thing::componentId<C1>();
+    auto c2 = ge::thing::componentId<C2>();
+
+    REQUIRE(c1 != c2);
+    REQUIRE(ge::thing::componentId<C1>() == c1);
+    REQUIRE(ge::thing::componentId<const C1>() == c1);
+}